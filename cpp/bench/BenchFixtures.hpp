@@ -0,0 +1,22 @@
+#pragma once
+
+// Fixtures shared by the benchmarks that drive a SyntheticBackend.
+
+#include "Extreme3DProService.hpp"
+
+namespace JoystickLibrary
+{
+    /**
+    * Gets the axes and buttons of an Extreme 3D Pro at rest, to plug in
+    * simulated ones.
+    */
+    inline JoystickState Extreme3DProCaps(const Extreme3DProService& service)
+    {
+        JoystickState state = JoystickState();
+        for (int code : { ABS_X, ABS_Y, ABS_RZ, ABS_THROTTLE, ABS_HAT0X, ABS_HAT0Y })
+            state.SetAxis(code, 0);
+        for (int i = 0; i < service.NUMBER_BUTTONS; i++)
+            state.SetButton(BTN_TRIGGER + i, false);
+        return state;
+    }
+}
@@ -0,0 +1,117 @@
+// Cold-start benchmark for device enumeration on real hardware.
+// Each run starts a fresh UdevBackend, scans with one of three filters and
+// opens every device the scan reports, which is what Enumerator::Start
+// does before the first device change is delivered:
+//
+//   all          every event node, as enumeration worked before filtering
+//   joysticks    only nodes udev tags ID_INPUT_JOYSTICK
+//   descriptors  joysticks whose udev vendor/product match a service
+//
+// Every result is printed as one CSV row, averaged over the runs:
+//
+//   filter,listed,opened,failed,scan_us,open_us,total_us
+//
+// failed counts nodes that could not be opened, e.g. for lack of permission.
+//
+// usage: cold_start_bench [runs]
+
+#include "Extreme3DProService.hpp"
+#include "Xbox360Service.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace JoystickLibrary;
+using Clock = std::chrono::steady_clock;
+
+struct RunResult
+{
+    double listed;
+    double opened;
+    double failed;
+    double scanUs;
+    double openUs;
+};
+
+static double Microseconds(Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 1000.0;
+}
+
+static bool RunOnce(const DeviceFilter& filter, RunResult& result)
+{
+    UdevBackend backend;
+    if (!backend.Start())
+        return false;
+    backend.SetFilter(filter);
+
+    auto start = Clock::now();
+    std::vector<std::string> paths;
+    backend.Scan(paths);
+    auto scanned = Clock::now();
+
+    int opened = 0;
+    for (const auto& path : paths)
+    {
+        std::unique_ptr<InputDevice> device = backend.Open(path.c_str());
+        if (device)
+            opened++;
+    }
+    auto end = Clock::now();
+
+    result.listed += paths.size();
+    result.opened += opened;
+    result.failed += paths.size() - opened;
+    result.scanUs += Microseconds(scanned - start);
+    result.openUs += Microseconds(end - scanned);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 20;
+    if (runs <= 0)
+    {
+        fprintf(stderr, "usage: cold_start_bench [runs]\n");
+        return 1;
+    }
+
+    Extreme3DProService& extreme = Extreme3DProService::GetInstance();
+    Xbox360Service& xbox = Xbox360Service::GetInstance();
+
+    DeviceFilter all;
+    DeviceFilter joysticks;
+    joysticks.joysticksOnly = true;
+    DeviceFilter descriptors = joysticks;
+    descriptors.everyDescriptor = false;
+    for (const auto& descriptor : extreme.EXTREME_3D_PRO_IDS)
+        descriptors.descriptors.insert(DescriptorKey(descriptor));
+    for (const auto& descriptor : xbox.XBOX_IDS)
+        descriptors.descriptors.insert(DescriptorKey(descriptor));
+
+    struct
+    {
+        const char *name;
+        const DeviceFilter *filter;
+    } filters[] = { { "all", &all }, { "joysticks", &joysticks }, { "descriptors", &descriptors } };
+
+    printf("filter,listed,opened,failed,scan_us,open_us,total_us\n");
+    for (const auto& entry : filters)
+    {
+        RunResult result = { };
+        for (int i = 0; i < runs; i++)
+        {
+            if (!RunOnce(*entry.filter, result))
+            {
+                fprintf(stderr, "could not start udev\n");
+                return 1;
+            }
+        }
+
+        printf("%s,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", entry.name, result.listed / runs, result.opened / runs,
+            result.failed / runs, result.scanUs / runs, result.openUs / runs, (result.scanUs + result.openUs) / runs);
+        fflush(stdout);
+    }
+
+    return 0;
+}
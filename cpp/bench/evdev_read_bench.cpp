@@ -0,0 +1,225 @@
+// Evdev read path benchmark on a uinput joystick.
+// Creates a virtual joystick through /dev/uinput, then repeatedly queues a
+// burst of reports on it (ABS_X, ABS_Y, BTN_TRIGGER, SYN_REPORT each) and
+// times draining the burst from its event node two ways:
+//
+//   libevdev   one libevdev_next_event call per event, as devices used to be read
+//   bulk       UdevBackend's devices: read() many records at once and decode them
+//
+// Both apply every event to a JoystickState. Bursts stay below the kernel's
+// per-client buffer so neither path sees SYN_DROPPED. Every result is
+// printed as one CSV row:
+//
+//   path,reports_per_burst,events,events_per_sec,ns_per_event
+//
+// Needs write access to /dev/uinput and read access to the new event node.
+//
+// usage: evdev_read_bench [bursts]
+
+#include "InputBackend.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+
+using namespace JoystickLibrary;
+using Clock = std::chrono::steady_clock;
+
+static const int EVENTS_PER_REPORT = 4;
+
+static void Apply(JoystickState& state, const struct input_event& ev)
+{
+    switch (ev.type)
+    {
+        case EV_KEY:
+            state.SetButton(ev.code, !!ev.value);
+            break;
+        case EV_ABS:
+            state.SetAxis(ev.code, ev.value);
+            break;
+        default:
+            break;
+    }
+}
+
+static int CreateJoystick(std::string& devnode)
+{
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    ioctl(fd, UI_SET_KEYBIT, BTN_TRIGGER);
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    for (int code : { ABS_X, ABS_Y })
+    {
+        struct uinput_abs_setup abs;
+        memset(&abs, 0, sizeof(struct uinput_abs_setup));
+        abs.code = code;
+        abs.absinfo.minimum = 0;
+        abs.absinfo.maximum = 1023;
+        ioctl(fd, UI_ABS_SETUP, &abs);
+    }
+
+    struct uinput_setup setup;
+    memset(&setup, 0, sizeof(struct uinput_setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x046d;
+    setup.id.product = 0xc215;
+    strncpy(setup.name, "evdev_read_bench", UINPUT_MAX_NAME_SIZE - 1);
+    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    // find the event node under the input device uinput just created
+    char sysname[64] = { 0 };
+    if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    std::string sysPath = std::string("/sys/devices/virtual/input/") + sysname;
+    for (int attempt = 0; attempt < 100 && devnode.empty(); attempt++)
+    {
+        DIR *dir = opendir(sysPath.c_str());
+        struct dirent *entry;
+        while (dir && (entry = readdir(dir)))
+        {
+            if (strncmp(entry->d_name, "event", 5) == 0)
+                devnode = std::string("/dev/input/") + entry->d_name;
+        }
+        if (dir)
+            closedir(dir);
+        // udev may still be creating the node
+        usleep(10000);
+    }
+    while (!devnode.empty() && access(devnode.c_str(), R_OK) != 0 && errno == ENOENT)
+        usleep(10000);
+    return fd;
+}
+
+static void QueueBurst(int uinput_fd, int reports, int& counter)
+{
+    static struct input_event burst[64 * EVENTS_PER_REPORT];
+    memset(burst, 0, sizeof(struct input_event) * reports * EVENTS_PER_REPORT);
+    for (int i = 0; i < reports; i++)
+    {
+        // the input core drops repeated values, so every report changes everything
+        counter++;
+        struct input_event *report = &burst[i * EVENTS_PER_REPORT];
+        report[0].type = EV_ABS;
+        report[0].code = ABS_X;
+        report[0].value = counter & 1023;
+        report[1].type = EV_ABS;
+        report[1].code = ABS_Y;
+        report[1].value = (counter * 7) & 1023;
+        report[2].type = EV_KEY;
+        report[2].code = BTN_TRIGGER;
+        report[2].value = counter & 1;
+        report[3].type = EV_SYN;
+        report[3].code = SYN_REPORT;
+    }
+    write(uinput_fd, burst, sizeof(struct input_event) * reports * EVENTS_PER_REPORT);
+}
+
+static uint64_t DrainLibevdev(struct libevdev *dev, JoystickState& state)
+{
+    uint64_t events = 0;
+    struct input_event ev;
+    while (libevdev_next_event(dev, LIBEVDEV_READ_FLAG_NORMAL, &ev) == LIBEVDEV_READ_STATUS_SUCCESS)
+    {
+        Apply(state, ev);
+        events++;
+    }
+    return events;
+}
+
+static uint64_t DrainBulk(InputDevice& device, JoystickState& state)
+{
+    uint64_t events = 0;
+    struct input_event ev;
+    while (device.Next(ev, false) == ReadStatus::SUCCESS)
+    {
+        Apply(state, ev);
+        events++;
+    }
+    return events;
+}
+
+static void Report(const char *path, int reports, uint64_t events, Clock::duration elapsed)
+{
+    double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / 1e9;
+    printf("%s,%d,%llu,%.0f,%.1f\n", path, reports, (unsigned long long) events, seconds > 0 ? events / seconds : 0.0,
+        events ? seconds * 1e9 / events : 0.0);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    int bursts = argc > 1 ? atoi(argv[1]) : 20000;
+    if (bursts <= 0)
+    {
+        fprintf(stderr, "usage: evdev_read_bench [bursts]\n");
+        return 1;
+    }
+
+    std::string devnode;
+    int uinput_fd = CreateJoystick(devnode);
+    if (uinput_fd < 0 || devnode.empty())
+    {
+        fprintf(stderr, "could not create a uinput joystick\n");
+        return 1;
+    }
+
+    int fd = open(devnode.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    struct libevdev *dev = nullptr;
+    UdevBackend backend;
+    std::unique_ptr<InputDevice> device = backend.Open(devnode.c_str());
+    if (fd < 0 || libevdev_new_from_fd(fd, &dev) < 0 || !device)
+    {
+        fprintf(stderr, "could not open %s\n", devnode.c_str());
+        return 1;
+    }
+
+    JoystickState state = JoystickState();
+    device->Seed(state);
+
+    printf("path,reports_per_burst,events,events_per_sec,ns_per_event\n");
+    int counter = 0;
+    for (int reports : { 1, 4, 12 })
+    {
+        // each burst reaches both readers; only the draining is timed
+        uint64_t libevdevEvents = 0;
+        uint64_t bulkEvents = 0;
+        Clock::duration libevdevTime = Clock::duration::zero();
+        Clock::duration bulkTime = Clock::duration::zero();
+        for (int i = 0; i < bursts; i++)
+        {
+            QueueBurst(uinput_fd, reports, counter);
+
+            auto start = Clock::now();
+            libevdevEvents += DrainLibevdev(dev, state);
+            auto middle = Clock::now();
+            bulkEvents += DrainBulk(*device, state);
+            auto end = Clock::now();
+
+            libevdevTime += middle - start;
+            bulkTime += end - middle;
+        }
+
+        Report("libevdev", reports, libevdevEvents, libevdevTime);
+        Report("bulk", reports, bulkEvents, bulkTime);
+    }
+
+    device.reset();
+    libevdev_free(dev);
+    close(fd);
+    ioctl(uinput_fd, UI_DEV_DESTROY);
+    close(uinput_fd);
+    return 0;
+}
@@ -0,0 +1,271 @@
+// Microbenchmarks for the query API as an application sees it.
+// Simulated devices are plugged into a SyntheticBackend and fed by a writer
+// thread at a fixed rate, so every update goes through the enumerator's
+// reader thread, while 1..N reader threads call one getter in a loop.
+// Every result is printed as one CSV row:
+//
+//   op,devices,threads,ns_per_op,allocs_per_op,ops
+//
+// ns_per_op is wall time per call on one thread, allocs_per_op counts calls
+// to operator new made by the measured threads. The device-change row times
+// one unplug or replug from the backend until the service callback ran, and
+// counts allocations on every thread.
+//
+// usage: joystick_bench [milliseconds_per_run] [max_threads]
+
+#include "BenchFixtures.hpp"
+#include "SyntheticBackend.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace JoystickLibrary;
+using Clock = std::chrono::steady_clock;
+
+static thread_local uint64_t threadAllocations = 0;
+static std::atomic<uint64_t> processAllocations(0);
+
+void *operator new(size_t size)
+{
+    threadAllocations++;
+    processAllocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// keeps the readers' results from being optimized out
+volatile int benchSink;
+
+// exposes the protected per-ID helpers to the benchmark and counts callbacks
+class BenchService : public Extreme3DProService
+{
+public:
+    using Extreme3DProService::GetState;
+    using Extreme3DProService::IsValidJoystickID;
+
+    void WaitForChanges(uint64_t count)
+    {
+        while (changes.load(std::memory_order_acquire) < count)
+            std::this_thread::yield();
+    }
+
+    std::atomic<uint64_t> changes { 0 };
+
+protected:
+    void OnDeviceChanged(DeviceStateChange ds)
+    {
+        Extreme3DProService::OnDeviceChanged(ds);
+        changes.fetch_add(1, std::memory_order_release);
+    }
+};
+
+static BenchService service;
+static SyntheticBackend *backend;
+
+struct RunResult
+{
+    double nsPerOp;
+    double allocsPerOp;
+    uint64_t ops;
+};
+
+static RunResult RunReaders(int threads, int millis, const std::vector<int>& ids, const std::function<int(int)>& op)
+{
+    const int BATCH = 256;
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> totalOps(0), totalAllocations(0), totalNs(0);
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < threads; t++)
+    {
+        readers.emplace_back([&, t]() {
+            uint64_t ops = 0;
+            int sink = 0;
+            size_t next = t % ids.size();
+            uint64_t allocationsBefore = threadAllocations;
+            auto start = Clock::now();
+
+            while (running.load(std::memory_order_relaxed))
+            {
+                for (int i = 0; i < BATCH; i++)
+                {
+                    sink += op(ids[next]);
+                    if (++next == ids.size())
+                        next = 0;
+                }
+                ops += BATCH;
+            }
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            benchSink = sink;
+            totalAllocations += threadAllocations - allocationsBefore;
+            totalNs += elapsed;
+            totalOps += ops;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    running = false;
+    for (auto& reader : readers)
+        reader.join();
+
+    RunResult result;
+    result.ops = totalOps.load();
+    result.nsPerOp = result.ops ? double(totalNs.load()) / result.ops : 0.0;
+    result.allocsPerOp = result.ops ? double(totalAllocations.load()) / result.ops : 0.0;
+    return result;
+}
+
+static RunResult RunDeviceChanges(int millis, const std::vector<std::shared_ptr<SyntheticDevice>>& devices)
+{
+    uint64_t ops = 0;
+    uint64_t allocationsBefore = processAllocations.load();
+    auto start = Clock::now();
+    auto end = start + std::chrono::milliseconds(millis);
+
+    while (Clock::now() < end)
+    {
+        for (auto& device : devices)
+        {
+            uint64_t changes = service.changes.load();
+            backend->Unplug(device->GetPath());
+            service.WaitForChanges(changes + 1);
+            backend->Plug(device->GetPath(), device->GetDescriptor(), Extreme3DProCaps(service));
+            service.WaitForChanges(changes + 2);
+        }
+        ops += 2 * devices.size();
+    }
+
+    RunResult result;
+    result.ops = ops;
+    result.nsPerOp = double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()) / ops;
+    result.allocsPerOp = double(processAllocations.load() - allocationsBefore) / ops;
+    return result;
+}
+
+static void Report(const char *op, int devices, int threads, const RunResult& result)
+{
+    printf("%s,%d,%d,%.1f,%.3f,%llu\n", op, devices, threads, result.nsPerOp, result.allocsPerOp,
+        static_cast<unsigned long long>(result.ops));
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    int millis = argc > 1 ? atoi(argv[1]) : 200;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (millis <= 0 || maxThreads < 0)
+    {
+        fprintf(stderr, "usage: joystick_bench [milliseconds_per_run] [max_threads]\n");
+        return 1;
+    }
+    if (maxThreads == 0)
+        maxThreads = 1;
+
+    backend = new SyntheticBackend();
+    Enumerator::GetInstance().SetBackend(std::unique_ptr<InputBackend>(backend));
+    if (!service.Initialize())
+    {
+        fprintf(stderr, "could not start the synthetic backend\n");
+        return 1;
+    }
+
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    printf("op,devices,threads,ns_per_op,allocs_per_op,ops\n");
+
+    std::vector<std::shared_ptr<SyntheticDevice>> plugged;
+    for (int devices : { 1, 4, 32 })
+    {
+        uint64_t changes = service.changes.load();
+        for (auto& device : plugged)
+            backend->Unplug(device->GetPath());
+        service.WaitForChanges(changes + plugged.size());
+        plugged.clear();
+
+        changes = service.changes.load();
+        for (int i = 0; i < devices; i++)
+        {
+            std::string path = "/dev/input/synthetic" + std::to_string(devices) + "-" + std::to_string(i);
+            plugged.push_back(backend->Plug(path, service.EXTREME_3D_PRO_IDS[0], Extreme3DProCaps(service)));
+        }
+        service.WaitForChanges(changes + devices);
+        std::vector<int> ids = service.GetIDs();
+
+        // one writer keeps every device changing at about 1 kHz
+        std::atomic<bool> feeding(true);
+        std::thread feeder([&]() {
+            int value = 0;
+            while (feeding.load(std::memory_order_relaxed))
+            {
+                value = (value + 1) & 1023;
+                for (auto& device : plugged)
+                {
+                    device->Emit(EV_ABS, ABS_X, value);
+                    device->Emit(EV_ABS, ABS_Y, 1023 - value);
+                    device->Emit(EV_ABS, ABS_HAT0X, (value >> 8 & 1) ? 1 : 0);
+                    device->Emit(EV_KEY, BTN_TRIGGER, value & 1);
+                    device->Report();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        for (int threads : threadCounts)
+        {
+            Report("GetX", devices, threads, RunReaders(threads, millis, ids, [](int id) {
+                int x = 0;
+                service.GetX(id, x);
+                return x;
+            }));
+            Report("GetButtons", devices, threads, RunReaders(threads, millis, ids, [](int id) {
+                std::map<Extreme3DProButton, bool> buttons;
+                service.GetButtons(id, buttons);
+                return static_cast<int>(buttons.size());
+            }));
+            Report("GetPOV", devices, threads, RunReaders(threads, millis, ids, [](int id) {
+                POV pov = POV::POV_NONE;
+                service.GetPOV(id, pov);
+                return static_cast<int>(pov);
+            }));
+            Report("GetState", devices, threads, RunReaders(threads, millis, ids, [](int id) {
+                return service.GetState(id).GetAxis(ABS_X);
+            }));
+            Report("IsValidJoystickID", devices, threads, RunReaders(threads, millis, ids, [](int id) {
+                return service.IsValidJoystickID(id) ? 1 : 0;
+            }));
+            Report("GetIDSnapshot", devices, threads, RunReaders(threads, millis, ids, [](int) {
+                return static_cast<int>(service.GetIDSnapshot()->version);
+            }));
+        }
+
+        feeding = false;
+        feeder.join();
+
+        // timed alone, so readers do not skew the callback latency
+        Report("DeviceChange", devices, 1, RunDeviceChanges(millis, plugged));
+    }
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Fixed-rate sampling benchmark: JoystickSampler against a sleep loop.
+// Eight simulated devices stream input at about 1 kHz each while joysticks
+// are sampled at 50, 100 and 250 Hz, first the way control loops used to
+// do it (sleep_for one period, then capture) and then with a
+// JoystickSampler. Both take one multi-device frame per sample with
+// Enumerator::GetAllSnapshots. Every run is printed as one CSV row:
+//
+//   mode,rate_hz,samples,missed,jitter_p50_us,jitter_p99_us,jitter_max_us,late_p99_us,drift_us
+//
+// jitter is how far each period between captures is from the nominal one;
+// late is capture time past the deadline of the sample. A sleep loop has
+// no deadlines, so its deadlines are counted from its first capture; it
+// never skips one, but falls behind them, which shows as missed and as the
+// drift of its last capture.
+//
+// usage: sampler_bench [milliseconds_per_run]
+
+#include "BenchFixtures.hpp"
+#include "JoystickSampler.hpp"
+#include "SyntheticBackend.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace JoystickLibrary;
+
+static const int LOAD_DEVICES = 8;
+
+static Extreme3DProService& service = Extreme3DProService::GetInstance();
+
+static double Microseconds(uint64_t ns)
+{
+    return ns / 1000.0;
+}
+
+static void Report(const char *mode, int rate, uint64_t samples, uint64_t missed, const LatencyHistogram& jitter,
+    const LatencyHistogram& lateness, uint64_t drift)
+{
+    LatencyStats j = jitter.GetStats();
+    printf("%s,%d,%llu,%llu,%.1f,%.1f,%.1f,%.1f,%.1f\n", mode, rate, (unsigned long long) samples,
+        (unsigned long long) missed, Microseconds(j.p50), Microseconds(j.p99), Microseconds(j.max),
+        Microseconds(lateness.GetPercentile(0.99)), Microseconds(drift));
+    fflush(stdout);
+}
+
+static void RunSleepLoop(int rate, int milliseconds)
+{
+    Enumerator& enumerator = Enumerator::GetInstance();
+    std::vector<DeviceSnapshot> frame(DeviceTable::CAPACITY);
+    uint64_t period = 1000000000ull / rate;
+    LatencyHistogram jitter;
+    LatencyHistogram lateness;
+
+    uint64_t first = 0;
+    uint64_t last = 0;
+    uint64_t samples = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(period));
+
+        uint64_t captureTime;
+        bool coherent;
+        enumerator.GetAllSnapshots(frame.data(), static_cast<int>(frame.size()), captureTime, coherent);
+        if (!first)
+            first = captureTime;
+        else
+        {
+            uint64_t actual = captureTime - last;
+            jitter.Record(actual > period ? actual - period : period - actual);
+        }
+
+        uint64_t deadline = first + samples * period;
+        lateness.Record(captureTime > deadline ? captureTime - deadline : 0);
+        last = captureTime;
+        samples++;
+    }
+
+    // the deadlines a fixed-rate loop would have met by the last capture
+    uint64_t due = (last - first) / period + 1;
+    uint64_t drift = last - (first + (samples - 1) * period);
+    Report("sleep", rate, samples, due > samples ? due - samples : 0, jitter, lateness, drift);
+}
+
+static void RunSampler(int rate, int milliseconds)
+{
+    JoystickSampler sampler;
+    SamplerOptions options;
+    options.rateHz = rate;
+
+    std::atomic<uint64_t> lastLateness(0);
+    auto callback = [&](const SampleFrame& sample) {
+        lastLateness.store(sample.captureTime - sample.deadline, std::memory_order_relaxed);
+    };
+    if (!sampler.Start(options, callback))
+    {
+        fprintf(stderr, "could not start the sampler\n");
+        exit(1);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    sampler.Stop();
+
+    SamplerStats stats = sampler.GetStats();
+    Report("timerfd", rate, stats.samples, stats.missed, sampler.GetPeriodJitter(), sampler.GetLateness(),
+        lastLateness.load());
+}
+
+int main(int argc, char **argv)
+{
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 5000;
+    if (milliseconds <= 0)
+    {
+        fprintf(stderr, "usage: sampler_bench [milliseconds_per_run]\n");
+        return 1;
+    }
+
+    SyntheticBackend *backend = new SyntheticBackend();
+    Enumerator& enumerator = Enumerator::GetInstance();
+    enumerator.SetBackend(std::unique_ptr<InputBackend>(backend));
+    if (!service.Initialize())
+    {
+        fprintf(stderr, "could not start the synthetic backend\n");
+        return 1;
+    }
+
+    std::vector<std::shared_ptr<SyntheticDevice>> load;
+    for (int i = 0; i < LOAD_DEVICES; i++)
+        load.push_back(backend->Plug("/dev/input/load" + std::to_string(i), service.EXTREME_3D_PRO_IDS[0],
+            Extreme3DProCaps(service)));
+    while (service.GetNumberConnected() < LOAD_DEVICES)
+        service.WaitForDevice(10);
+
+    std::atomic<bool> feeding(true);
+    std::thread feeder([&]() {
+        int value = 0;
+        while (feeding.load(std::memory_order_relaxed))
+        {
+            value = (value + 1) & 1023;
+            for (auto& device : load)
+            {
+                device->Emit(EV_ABS, ABS_X, value);
+                device->Emit(EV_KEY, BTN_TRIGGER, value & 1);
+                device->Report();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    printf("mode,rate_hz,samples,missed,jitter_p50_us,jitter_p99_us,jitter_max_us,late_p99_us,drift_us\n");
+    for (int rate : { 50, 100, 250 })
+    {
+        RunSleepLoop(rate, milliseconds);
+        RunSampler(rate, milliseconds);
+    }
+
+    feeding = false;
+    feeder.join();
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Multi-reader scaling benchmark for the per-device snapshot publication.
+// One writer publishes JoystickState updates at a fixed rate while 1..16
+// readers copy snapshots as fast as they can, once through SeqLock and once
+// through a mutex-guarded copy (the old jsMapLock scheme) for comparison.
+//
+// usage: seqlock_bench [milliseconds_per_run] [writer_hz]
+
+#include "Types.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using JoystickLibrary::SeqLock;
+using Clock = std::chrono::steady_clock;
+
+// keeps the readers' loads from being optimized out
+volatile int benchSink;
+
+struct MutexPublisher
+{
+    void Store(const JoystickState& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = value;
+    }
+
+    void Load(JoystickState& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        value = state;
+    }
+
+    std::mutex mutex;
+    JoystickState state = JoystickState();
+};
+
+template <typename Publisher>
+double RunScaling(Publisher& publisher, int readers, int millis, int writerHz)
+{
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> totalReads(0);
+    std::vector<std::thread> threads;
+
+    std::thread writer([&]() {
+        JoystickState state = JoystickState();
+        auto period = std::chrono::nanoseconds(1000000000LL / writerHz);
+        auto next = Clock::now();
+        int value = 0;
+        while (running.load(std::memory_order_relaxed))
+        {
+            state.SetAxis(ABS_X, value++);
+            state.SetButton(BTN_TRIGGER, value & 1);
+            publisher.Store(state);
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    for (int i = 0; i < readers; i++)
+    {
+        threads.emplace_back([&]() {
+            JoystickState state;
+            uint64_t reads = 0;
+            int sink = 0;
+            while (running.load(std::memory_order_relaxed))
+            {
+                publisher.Load(state);
+                sink += state.GetAxis(ABS_X);
+                reads++;
+            }
+            benchSink = sink;
+            totalReads += reads;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    running = false;
+    for (auto& t : threads)
+        t.join();
+    writer.join();
+
+    return totalReads.load() / (millis / 1000.0);
+}
+
+struct SeqLockPublisher
+{
+    void Store(const JoystickState& value) { lock.Store(value); }
+    void Load(JoystickState& value) { lock.Load(value); }
+    SeqLock<JoystickState> lock;
+};
+
+int main(int argc, char **argv)
+{
+    int millis = argc > 1 ? atoi(argv[1]) : 500;
+    int writerHz = argc > 2 ? atoi(argv[2]) : 1000;
+    if (millis <= 0 || writerHz <= 0)
+    {
+        std::cerr << "usage: seqlock_bench [milliseconds_per_run] [writer_hz]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "state size: " << sizeof(JoystickState) << " bytes, writer: " << writerHz << " Hz" << std::endl;
+    std::cout << std::setw(8) << "readers"
+        << std::setw(18) << "seqlock reads/s"
+        << std::setw(18) << "mutex reads/s"
+        << std::setw(10) << "speedup" << std::endl;
+
+    for (int readers : { 1, 2, 4, 8, 16 })
+    {
+        SeqLockPublisher seqlock;
+        MutexPublisher mutex;
+        double seq = RunScaling(seqlock, readers, millis, writerHz);
+        double mtx = RunScaling(mutex, readers, millis, writerHz);
+
+        std::cout << std::setw(8) << readers
+            << std::setw(18) << std::fixed << std::setprecision(0) << seq
+            << std::setw(18) << mtx
+            << std::setw(10) << std::setprecision(2) << (mtx > 0 ? seq / mtx : 0.0) << std::endl;
+    }
+
+    return 0;
+}
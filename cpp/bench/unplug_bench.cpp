@@ -0,0 +1,138 @@
+// Hot-unplug latency benchmark.
+// One simulated device is plugged into a SyntheticBackend and unplugged
+// over and over while 0..N other devices stream input at about 1 kHz each.
+// Every unplug is timed from the backend call until the service's REMOVED
+// callback ran. Results are printed as one CSV row per load:
+//
+//   load_devices,unplugs,p50_us,p99_us,max_us,reader_p99_us,reader_max_us
+//
+// reader_* is the enumerator's own removal histogram, from the reader thread
+// waking up to the REMOVED callbacks returning.
+//
+// usage: unplug_bench [unplugs_per_load]
+
+#include "BenchFixtures.hpp"
+#include "SyntheticBackend.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace JoystickLibrary;
+
+class BenchService : public Extreme3DProService
+{
+public:
+    std::atomic<uint64_t> added { 0 };
+    std::atomic<uint64_t> removed { 0 };
+    std::atomic<uint64_t> removedAt { 0 };
+
+protected:
+    void OnDeviceChanged(DeviceStateChange ds)
+    {
+        Extreme3DProService::OnDeviceChanged(ds);
+        if (ds.state == DeviceStateChange::State::REMOVED)
+        {
+            removedAt.store(MonotonicNanoseconds(), std::memory_order_relaxed);
+            removed.fetch_add(1, std::memory_order_release);
+        }
+        else
+            added.fetch_add(1, std::memory_order_release);
+    }
+};
+
+static BenchService service;
+static SyntheticBackend *backend;
+
+static void WaitFor(const std::atomic<uint64_t>& counter, uint64_t count)
+{
+    while (counter.load(std::memory_order_acquire) < count)
+        std::this_thread::yield();
+}
+
+static double Microseconds(uint64_t ns)
+{
+    return ns / 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    int unplugs = argc > 1 ? atoi(argv[1]) : 2000;
+    if (unplugs <= 0)
+    {
+        fprintf(stderr, "usage: unplug_bench [unplugs_per_load]\n");
+        return 1;
+    }
+
+    backend = new SyntheticBackend();
+    Enumerator& enumerator = Enumerator::GetInstance();
+    enumerator.SetBackend(std::unique_ptr<InputBackend>(backend));
+    if (!service.Initialize())
+    {
+        fprintf(stderr, "could not start the synthetic backend\n");
+        return 1;
+    }
+
+    printf("load_devices,unplugs,p50_us,p99_us,max_us,reader_p99_us,reader_max_us\n");
+
+    std::vector<std::shared_ptr<SyntheticDevice>> load;
+    for (int devices : { 0, 8, 32 })
+    {
+        while (static_cast<int>(load.size()) < devices)
+        {
+            uint64_t added = service.added.load();
+            std::string path = "/dev/input/load" + std::to_string(load.size());
+            load.push_back(backend->Plug(path, service.EXTREME_3D_PRO_IDS[0], Extreme3DProCaps(service)));
+            WaitFor(service.added, added + 1);
+        }
+
+        std::atomic<bool> feeding(true);
+        std::thread feeder([&]() {
+            int value = 0;
+            while (feeding.load(std::memory_order_relaxed))
+            {
+                value = (value + 1) & 1023;
+                for (auto& device : load)
+                {
+                    device->Emit(EV_ABS, ABS_X, value);
+                    device->Emit(EV_KEY, BTN_TRIGGER, value & 1);
+                    device->Report();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        LatencyHistogram latency;
+        enumerator.ResetRemovalLatencyStats();
+        for (int i = 0; i < unplugs; i++)
+        {
+            uint64_t added = service.added.load();
+            std::shared_ptr<SyntheticDevice> target =
+                backend->Plug("/dev/input/target", service.EXTREME_3D_PRO_IDS[0], Extreme3DProCaps(service));
+            WaitFor(service.added, added + 1);
+
+            uint64_t removed = service.removed.load();
+            uint64_t start = MonotonicNanoseconds();
+            backend->Unplug(target->GetPath());
+            WaitFor(service.removed, removed + 1);
+            uint64_t end = service.removedAt.load(std::memory_order_relaxed);
+            latency.Record(end > start ? end - start : 0);
+
+            while (!target->IsReleased())
+                std::this_thread::yield();
+        }
+
+        feeding = false;
+        feeder.join();
+
+        LatencyStats total = latency.GetStats();
+        LatencyStats reader = enumerator.GetRemovalLatencyStats();
+        printf("%d,%d,%.1f,%.1f,%.1f,%.1f,%.1f\n", devices, unplugs, Microseconds(total.p50), Microseconds(total.p99),
+            Microseconds(total.max), Microseconds(reader.p99), Microseconds(reader.max));
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Reader mode benchmark: syscalls per input event, epoll against io_uring.
+// Each run forks a child, since the enumerator is a process-wide singleton
+// whose reader mode is fixed at Start. The child plugs N devices into a
+// PipeBackend and a writer thread sends every device a report (ABS_X,
+// BTN_TRIGGER, SYN_REPORT in one write, as evdev delivers it) about every
+// millisecond. Every result is printed as one CSV row:
+//
+//   mode,devices,events,wakeups,enters,reads,syscalls_per_event
+//
+// reads is the process's read syscalls from /proc/self/io (syscr), taken
+// while the writer runs; syscalls_per_event counts them together with the
+// reader's epoll_wait and io_uring_enter calls. mode is the mode in effect,
+// so a kernel without io_uring shows up as a second epoll row.
+//
+// usage: uring_bench [milliseconds_per_run]
+
+#include "Enumerator.hpp"
+#include "PipeBackend.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+using namespace JoystickLibrary;
+
+static uint64_t ReadSyscalls()
+{
+    FILE *io = fopen("/proc/self/io", "r");
+    if (!io)
+        return 0;
+
+    char line[128];
+    unsigned long long count = 0;
+    while (fgets(line, sizeof(line), io))
+    {
+        if (sscanf(line, "syscr: %llu", &count) == 1)
+            break;
+    }
+    fclose(io);
+    return count;
+}
+
+static int RunOnce(ReaderMode mode, int devices, int milliseconds)
+{
+    PipeBackend *backend = new PipeBackend();
+    Enumerator& enumerator = Enumerator::GetInstance();
+    enumerator.SetBackend(std::unique_ptr<InputBackend>(backend));
+    enumerator.SetReaderMode(mode);
+
+    JoystickState initial = JoystickState();
+    initial.SetAxis(ABS_X, 0);
+    initial.SetButton(BTN_TRIGGER, false);
+
+    std::vector<int> writers;
+    for (int i = 0; i < devices; i++)
+    {
+        int fds[2];
+        if (pipe(fds) < 0)
+            return 1;
+        backend->Attach("/dev/input/pipe" + std::to_string(i), { 0x046d, 0xc215 }, fds[0], initial);
+        writers.push_back(fds[1]);
+    }
+
+    if (!enumerator.Start())
+    {
+        fprintf(stderr, "could not start the pipe backend\n");
+        return 1;
+    }
+    while (enumerator.GetNumberConnected() < devices)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    ReaderStats before = enumerator.GetReaderStats();
+    uint64_t readsBefore = ReadSyscalls();
+
+    std::thread writer([&]() {
+        struct input_event frame[3];
+        memset(frame, 0, sizeof(frame));
+        frame[0].type = EV_ABS;
+        frame[0].code = ABS_X;
+        frame[1].type = EV_KEY;
+        frame[1].code = BTN_TRIGGER;
+        frame[2].type = EV_SYN;
+        frame[2].code = SYN_REPORT;
+
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+        for (int value = 0; std::chrono::steady_clock::now() < end; value++)
+        {
+            frame[0].value = value & 1023;
+            frame[1].value = value & 1;
+            for (int fd : writers)
+                write(fd, frame, sizeof(frame));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    writer.join();
+
+    // let the reader drain what is still queued
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t reads = ReadSyscalls() - readsBefore;
+    ReaderStats after = enumerator.GetReaderStats();
+
+    uint64_t events = after.events - before.events;
+    uint64_t wakeups = after.wakeups - before.wakeups;
+    uint64_t enters = after.submits - before.submits;
+    printf("%s,%d,%llu,%llu,%llu,%llu,%.3f\n", enumerator.GetReaderMode() == ReaderMode::IO_URING ? "io_uring" : "epoll",
+        devices, (unsigned long long) events, (unsigned long long) wakeups, (unsigned long long) enters,
+        (unsigned long long) reads, events ? double(wakeups + enters + reads) / events : 0.0);
+    fflush(stdout);
+
+    // skip the singleton's teardown; the process is done
+    _exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    int milliseconds = argc > 1 ? atoi(argv[1]) : 2000;
+    if (milliseconds <= 0)
+    {
+        fprintf(stderr, "usage: uring_bench [milliseconds_per_run]\n");
+        return 1;
+    }
+
+    printf("mode,devices,events,wakeups,enters,reads,syscalls_per_event\n");
+    fflush(stdout);
+
+    for (ReaderMode mode : { ReaderMode::EPOLL, ReaderMode::IO_URING })
+    {
+        for (int devices : { 1, 8, 32 })
+        {
+            pid_t child = fork();
+            if (child < 0)
+                return 1;
+            if (child == 0)
+                return RunOnce(mode, devices, milliseconds);
+
+            int status;
+            waitpid(child, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+
+namespace JoystickLibrary
+{
+    /**
+    * Maps raw axis values linearly from one end of a range to the other
+    * (from reads low, to reads high), rounding toward zero exactly as
+    * integer division would. The division by the range is done as a
+    * multiply-shift by a precomputed reciprocal, chosen per Granlund and
+    * Montgomery so that it is exact for every value in range. Applying it is
+    * a clamp, a multiply-add and a multiply-shift; raw values outside the
+    * range are clamped to it.
+    */
+    class AxisScale
+    {
+    public:
+        static constexpr int64_t MAX_SPAN = int64_t(1) << 24;
+        static constexpr int MAX_OUTPUT = 127;
+
+        /**
+        * Checks that a range and outputs are small enough for the reciprocal to be exact.
+        */
+        static constexpr bool Fits(int from, int to, int low, int high)
+        {
+            return Span(from, to) <= MAX_SPAN && Bound(low, high) <= MAX_OUTPUT;
+        }
+
+        /**
+        * An empty range; Apply always reads 0.
+        */
+        constexpr AxisScale()
+            : AxisScale(0, 0, 0, 0)
+        {
+        }
+
+        constexpr AxisScale(int from, int to, int low, int high)
+            : lowest(from < to ? from : to),
+              highest(from < to ? to : from),
+              divisor(Span(from, to)),
+              multiplier(from == to ? 0 : Direction(from, to) * (int64_t(high) - low)),
+              addend(from == to ? low
+                  : Direction(from, to) * (int64_t(low) * (int64_t(to) - from) - (int64_t(high) - low) * from)),
+              shift(Shift(from, to, low, high)),
+              reciprocal(Reciprocal(Span(from, to), Shift(from, to, low, high)))
+        {
+        }
+
+        constexpr int Apply(int raw) const
+        {
+            return Truncate(multiplier * Clamp(raw) + addend);
+        }
+
+        /**
+        * The same mapping done with a real division; for checking Apply.
+        */
+        constexpr int Reference(int raw) const
+        {
+            return static_cast<int>((multiplier * Clamp(raw) + addend) / divisor);
+        }
+
+    private:
+        static constexpr int64_t Span(int from, int to)
+        {
+            return from == to ? 1 : (from < to ? int64_t(to) - from : int64_t(from) - to);
+        }
+
+        static constexpr int64_t Direction(int from, int to)
+        {
+            return from < to ? 1 : -1;
+        }
+
+        static constexpr int64_t Bound(int low, int high)
+        {
+            return (low < 0 ? -int64_t(low) : low) > (high < 0 ? -int64_t(high) : high)
+                ? (low < 0 ? -int64_t(low) : low) : (high < 0 ? -int64_t(high) : high);
+        }
+
+        static constexpr int CeilLog2(uint64_t value, int bits = 0)
+        {
+            return (uint64_t(1) << bits) >= value ? bits : CeilLog2(value, bits + 1);
+        }
+
+        // numerators reach Bound * span, so 2^shift >= Bound * span^2 keeps the rounding error below 1 / span
+        static constexpr int Shift(int from, int to, int low, int high)
+        {
+            return CeilLog2(uint64_t(Bound(low, high) + 1) * uint64_t(Span(from, to)) * uint64_t(Span(from, to)));
+        }
+
+        static constexpr uint64_t Reciprocal(int64_t span, int shift)
+        {
+            return ((uint64_t(1) << shift) + uint64_t(span) - 1) / uint64_t(span);
+        }
+
+        constexpr int64_t Clamp(int raw) const
+        {
+            return raw < lowest ? lowest : (raw > highest ? highest : raw);
+        }
+
+        constexpr int Truncate(int64_t numerator) const
+        {
+            return numerator < 0 ? -Quotient(uint64_t(-numerator)) : Quotient(uint64_t(numerator));
+        }
+
+        constexpr int Quotient(uint64_t numerator) const
+        {
+            return static_cast<int>((numerator * reciprocal) >> shift);
+        }
+
+        int lowest;
+        int highest;
+        int64_t divisor;
+        int64_t multiplier;
+        int64_t addend;
+        int shift;
+        uint64_t reciprocal;
+    };
+
+    template <int... I>
+    struct IndexList
+    {
+    };
+
+    template <int N, int... I>
+    struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...>
+    {
+    };
+
+    template <int... I>
+    struct MakeIndexList<0, I...>
+    {
+        typedef IndexList<I...> Type;
+    };
+
+    /**
+    * An AxisScale expanded into a table with one entry per raw value, for
+    * ranges of up to 256 values such as 8-bit axes. Built at compile time
+    * from the same kernel, so it reads identically.
+    */
+    template <int From, int To, int Low, int High,
+        typename Indices = typename MakeIndexList<(From < To ? To - From : From - To) + 1>::Type>
+    struct AxisTable;
+
+    template <int From, int To, int Low, int High, int... I>
+    struct AxisTable<From, To, Low, High, IndexList<I...>>
+    {
+        static_assert(sizeof...(I) <= 256, "tables are for ranges of up to 256 values");
+
+        static constexpr int LOWEST = From < To ? From : To;
+        static constexpr int SIZE = sizeof...(I);
+        static constexpr AxisScale SCALE = AxisScale(From, To, Low, High);
+        static constexpr int8_t VALUES[SIZE] = { static_cast<int8_t>(SCALE.Apply(LOWEST + I))... };
+
+        static constexpr int Apply(int raw)
+        {
+            return VALUES[raw <= LOWEST ? 0 : (raw - LOWEST >= SIZE ? SIZE - 1 : raw - LOWEST)];
+        }
+    };
+
+    template <int From, int To, int Low, int High, int... I>
+    constexpr AxisScale AxisTable<From, To, Low, High, IndexList<I...>>::SCALE;
+
+    template <int From, int To, int Low, int High, int... I>
+    constexpr int8_t AxisTable<From, To, Low, High, IndexList<I...>>::VALUES[];
+
+    /**
+    * A compile-time axis mapping: an AxisTable for ranges of up to 256
+    * values, an AxisScale otherwise.
+    */
+    template <int From, int To, int Low, int High,
+        bool Tabulated = ((From < To ? To - From : From - To) < 256)>
+    struct AxisMap
+    {
+        static_assert(AxisScale::Fits(From, To, Low, High), "axis range or output too wide for an exact AxisScale");
+
+        static constexpr AxisScale SCALE = AxisScale(From, To, Low, High);
+
+        static constexpr int Apply(int raw)
+        {
+            return SCALE.Apply(raw);
+        }
+    };
+
+    template <int From, int To, int Low, int High, bool Tabulated>
+    constexpr AxisScale AxisMap<From, To, Low, High, Tabulated>::SCALE;
+
+    template <int From, int To, int Low, int High>
+    struct AxisMap<From, To, Low, High, true> : AxisTable<From, To, Low, High>
+    {
+    };
+
+    template <typename Map>
+    constexpr bool IsExactRun(int raw, int last, int step)
+    {
+        return raw >= last ? Map::Apply(last) == Map::SCALE.Reference(last)
+            : Map::Apply(raw) == Map::SCALE.Reference(raw) && IsExactRun<Map>(raw + step, last, step);
+    }
+
+    /**
+    * Checks an AxisMap against real division at every step-th raw value
+    * from first up to last, and at last; for static_asserts.
+    */
+    template <typename Map>
+    constexpr bool IsExactMap(int first, int last, int step)
+    {
+        return (last - first) / step < 16 ? IsExactRun<Map>(first, last, step)
+            : IsExactMap<Map>(first, first + (last - first) / step / 2 * step, step)
+                && IsExactMap<Map>(first + (last - first) / step / 2 * step, last, step);
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Types.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace JoystickLibrary
+{
+    /**
+    * Stable-address table of devices keyed by joystick ID.
+    * Storage is split into fixed-size shards that are allocated on first use.
+    * Entries are never moved or freed while the table lives, so lookups take
+    * no lock and a pointer returned by Find stays valid. Each entry carries its
+    * own lock for connect/disconnect; see JoystickData::lock.
+    */
+    class DeviceTable
+    {
+    public:
+        static const int SHARD_SIZE = 32;
+        static const int MAX_SHARDS = 32;
+        static const int CAPACITY = SHARD_SIZE * MAX_SHARDS;
+
+        DeviceTable()
+        {
+            for (auto& shard : shards)
+                shard.store(nullptr, std::memory_order_relaxed);
+        }
+
+        ~DeviceTable()
+        {
+            for (auto& shard : shards)
+            {
+                Shard *s = shard.load(std::memory_order_relaxed);
+                if (!s)
+                    continue;
+                for (auto& slot : s->slots)
+                    delete slot.load(std::memory_order_relaxed);
+                delete s;
+            }
+        }
+
+        DeviceTable(DeviceTable const&) = delete;
+        void operator=(DeviceTable const&) = delete;
+
+        /**
+        * Looks up a device without locking.
+        * @param id the joystick ID
+        * @return the device, or nullptr if the ID was never assigned.
+        */
+        JoystickData *Find(int id) const
+        {
+            if (id < 0 || id >= CAPACITY)
+                return nullptr;
+
+            Shard *shard = shards[id / SHARD_SIZE].load(std::memory_order_acquire);
+            if (!shard)
+                return nullptr;
+            return shard->slots[id % SHARD_SIZE].load(std::memory_order_acquire);
+        }
+
+        /**
+        * Publishes a fully initialized device under a new ID.
+        * @param id the joystick ID
+        * @param jsData the device; the table takes ownership on success.
+        * @return false if the ID is out of range or already taken.
+        */
+        bool Insert(int id, std::unique_ptr<JoystickData> jsData)
+        {
+            if (id < 0 || id >= CAPACITY)
+                return false;
+
+            std::lock_guard<std::mutex> lock(insertLock);
+            Shard *shard = shards[id / SHARD_SIZE].load(std::memory_order_relaxed);
+            if (!shard)
+            {
+                shard = new Shard();
+                shards[id / SHARD_SIZE].store(shard, std::memory_order_release);
+            }
+
+            auto& slot = shard->slots[id % SHARD_SIZE];
+            if (slot.load(std::memory_order_relaxed))
+                return false;
+            slot.store(jsData.release(), std::memory_order_release);
+            return true;
+        }
+
+        /**
+        * Calls f(id, JoystickData&) for every assigned ID, in ID order.
+        */
+        template <typename F>
+        void ForEach(F f) const
+        {
+            for (int i = 0; i < MAX_SHARDS; i++)
+            {
+                Shard *shard = shards[i].load(std::memory_order_acquire);
+                if (!shard)
+                    continue;
+
+                for (int j = 0; j < SHARD_SIZE; j++)
+                {
+                    JoystickData *jsData = shard->slots[j].load(std::memory_order_acquire);
+                    if (jsData)
+                        f(i * SHARD_SIZE + j, *jsData);
+                }
+            }
+        }
+
+    private:
+        struct Shard
+        {
+            Shard()
+            {
+                for (auto& slot : slots)
+                    slot.store(nullptr, std::memory_order_relaxed);
+            }
+
+            std::atomic<JoystickData *> slots[SHARD_SIZE];
+        };
+
+        std::atomic<Shard *> shards[MAX_SHARDS];
+        std::mutex insertLock;
+    };
+}
@@ -1,16 +1,59 @@
 #pragma once
 #include "Types.hpp"
+#include <atomic>
+
+#ifdef __linux__
+    #include "DeviceTable.hpp"
+    #include "InputBackend.hpp"
+    #include "InputRecording.hpp"
+    #include "InputSubscription.hpp"
+    #include "InputWaiter.hpp"
+    #include <condition_variable>
+    #include <deque>
+    #include <memory>
+    #include <unordered_map>
+    #include <unordered_set>
+#endif
 
 namespace JoystickLibrary
 {
     typedef std::function<void(DeviceStateChange)> DeviceChangeCallback;
+#ifdef __linux__
+#ifdef __cpp_impl_coroutine
+    // see JoystickCoroutines.hpp
+    class CoroutineExecutor;
+    class DeviceChangeAwaiter;
+#endif
 
-    struct EnumeratorImpl
+    typedef std::vector<std::shared_ptr<InputSubscription>> SubscriberList;
+
+    // see UringReader.hpp; only built where the kernel headers have io_uring
+    class UringReader;
+
+    /**
+    * How the reader thread reads joystick fds.
+    */
+    enum class ReaderMode
     {
-        // common implementation fields //
-        std::map<int, JoystickData> jsMap;
+        EPOLL,      /**< Wait on every fd with epoll and read each one until EAGAIN.                */
+        IO_URING    /**< Keep a read posted on every fd in an io_uring and reap them in batches.    */
+    };
 
+    /**
+    * Reader thread counters since Start, for comparing reader modes.
+    */
+    struct ReaderStats
+    {
+        uint64_t wakeups;   /**< Returns from epoll_wait.                   */
+        uint64_t submits;   /**< io_uring_enter calls; 0 in EPOLL mode.     */
+        uint64_t events;    /**< Input events read from devices.            */
+    };
+#endif
+
+    struct EnumeratorImpl
+    {
 #ifdef _WIN32
+        std::map<int, JoystickData> jsMap;
         HWND enumerationhWnd;
         HDEVNOTIFY enumerationHNotify;
         HANDLE enumThread;
@@ -41,37 +84,64 @@ namespace JoystickLibrary
             enumThread = nullptr;
         }
 #elif __linux__
-        struct udev *udev;
-        struct udev_monitor *udev_monitor;
-        int udev_mon_fd;
-        std::thread deviceListenerThread;
-        std::mutex jsMapLock;
-        int udev_select_pipe[2];
-
-        EnumeratorImpl()
-        {
-            udev = nullptr;
-            udev_monitor = nullptr;
-        }
+        std::unique_ptr<InputBackend> backend;
+        int epoll_fd;
+        int shutdown_fd;
+        // bumped when callbacks want devices the last scan skipped
+        int rescan_fd;
+        // one-shot timer that keeps smoothed axes moving while no input arrives
+        int settle_fd;
+        bool settleArmed;
+        std::atomic<uint64_t> shapingVersion;
+        std::thread readerThread;
+        DeviceTable devices;
+        // reader thread only: the ID last connected at each devnode and under each stable identity
+        std::unordered_map<std::string, int> devnodeIndex;
+        std::unordered_map<std::string, int> stableIndex;
+        // reader thread only: disconnected IDs, oldest first, each once; reused once the table is full
+        std::deque<int> retiredIDs;
+        // guards the callback lists only; never held while a callback runs
+        std::mutex callbackLock;
+        // callbacks that only want some devices, keyed by DescriptorKey; guarded by callbackLock
+        std::unordered_map<uint32_t, std::vector<DeviceChangeCallback>> routes;
+        // serializes announcements and device changes, so each callback sees a device's
+        // ADDED before its REMOVED; recursive so callbacks can register more callbacks
+        std::recursive_mutex notifyLock;
+        // odd while the reader thread is publishing a batch of device updates
+        std::atomic<uint64_t> frameSequence;
+        // copy-on-write; replaced under subscriberLock, read with atomic_load
+        std::shared_ptr<const SubscriberList> subscribers;
+        std::mutex subscriberLock;
+        std::atomic<bool> queryLatencyTracking;
+        // when the reader thread last woke up, and how long removals took from there
+        uint64_t wakeTime;
+        LatencyHistogram removeLatency;
+        // set while recording; replaced under recorderLock, read with atomic_load
+        std::shared_ptr<InputRecorder> recorder;
+        std::mutex recorderLock;
+        ReaderMode readerMode;
+        // set by Start in IO_URING mode unless the kernel refused; reader thread only from then on
+        std::unique_ptr<UringReader> uring;
+        std::atomic<uint64_t> wakeups;
+        std::atomic<uint64_t> eventsRead;
+        // intrusive lists of InputWaiters: per device, for device changes and done but
+        // not fired yet, so RemoveWaiter can still cancel those; guarded by waiterLock
+        std::mutex waiterLock;
+        InputWaiter *inputWaiters[DeviceTable::CAPACITY];
+        InputWaiter *changeWaiters;
+        InputWaiter *firingWaiters;
+        // devices that can be waited on: from before their ADDED callbacks until REMOVED
+        bool waitable[DeviceTable::CAPACITY];
+        // lets the reader skip waiterLock while nobody waits on input
+        std::atomic<int> inputWaiterCount;
+        // set once the reader thread connected the devices present at Start; guarded by readyLock
+        bool ready;
+        std::mutex readyLock;
+        std::condition_variable readyCondition;
 
-        ~EnumeratorImpl()
-        {
-            if (udev)
-                udev_unref(udev);
-            if (udev_monitor)
-                udev_monitor_unref(udev_monitor);
-            if (deviceListenerThread.joinable())
-            {
-                // write some random byte to the pipe to break out of the select loop
-                uint8_t zero = 0;
-                write(udev_select_pipe[1], &zero, sizeof(uint8_t));
-                // join the select loop thread
-                deviceListenerThread.join();
-                // clean up the pipe
-                close(udev_select_pipe[0]);
-                close(udev_select_pipe[1]);
-            }
-        }
+        // out of line, where UringReader is complete
+        EnumeratorImpl();
+        ~EnumeratorImpl();
 #else
         #error Not currently supported!
 #endif
@@ -95,21 +165,227 @@ namespace JoystickLibrary
         void __run_enum(const void *context = nullptr);
         void __run_remove(const void *context = nullptr);
 
+#ifdef __linux__
+        /**
+        * Captures every connected joystick into one multi-device frame.
+        * The capture is retried while the reader thread publishes a batch,
+        * so that normally no device in the frame is from a later reader
+        * batch than any other. Under input that never lets up, it settles
+        * for a frame in which each device is only consistent on its own.
+        * @param snapshots caller-provided buffer to fill, one entry per device
+        * @param capacity the number of entries in snapshots
+        * @param captureTime A reference in which to save the CLOCK_MONOTONIC capture time, in ns.
+        * @param coherent A reference set to true if every device is from the same reader batch, false otherwise.
+        * @return the number of entries written.
+        */
+        int GetAllSnapshots(DeviceSnapshot *snapshots, int capacity, uint64_t& captureTime, bool& coherent);
+
+        /**
+        * Starts delivering axis, button and POV changes to a new queue.
+        * Events are pushed from the reader thread as they are read.
+        * @param options which devices and event types to deliver, and the queue's size and overflow policy
+        * @return the subscription; keep it until calling Unsubscribe.
+        */
+        std::shared_ptr<InputSubscription> Subscribe(const SubscriptionOptions& options);
+
+        /**
+        * Stops delivery to a subscription and wakes anyone waiting on it.
+        * @param subscription a subscription returned by Subscribe
+        */
+        void Unsubscribe(const std::shared_ptr<InputSubscription>& subscription);
+
+        /**
+        * Gets the raw event ring of a device. The ring lives as long as the
+        * enumerator and keeps filling across reconnects of the same ID; when
+        * the ID goes to another device its cursors go stale, see EventRing.
+        * @param id the joystick ID
+        * @return the ring, or nullptr if the ID was never assigned.
+        */
+        const EventRing *GetEventRing(int id) const;
+
+        /**
+        * Gets the latency histogram summary of a device. Timestamps come from
+        * the kernel on CLOCK_MONOTONIC.
+        * @param id the joystick ID
+        * @param kind APPLY for event-to-publish, QUERY for event-to-getter
+        * @param stats A reference in which to save the summary. Will not be modified if call fails.
+        * @return false if the ID was never assigned, true otherwise.
+        */
+        bool GetLatencyStats(int id, LatencyKind kind, LatencyStats& stats) const;
+
+        /**
+        * Clears both latency histograms of a device.
+        * @return false if the ID was never assigned, true otherwise.
+        */
+        bool ResetLatencyStats(int id);
+
+        /**
+        * Gets p50/p99/max removal latency across all devices: from the reader
+        * thread waking up to an unplug, whether through a hangup or read
+        * error on the device or a udev remove event, until every REMOVED
+        * callback has returned. Callbacks run on the reader thread, so a
+        * slow one shows up here.
+        */
+        LatencyStats GetRemovalLatencyStats() const;
+
+        /**
+        * Clears the removal latency histogram.
+        */
+        void ResetRemovalLatencyStats();
+
+        /**
+        * Gets the range an axis of a device reported when it last connected.
+        * @param id the joystick ID
+        * @param code the ABS_* code
+        * @param range A reference in which to save the range. Will not be modified if call fails.
+        * @return false if the ID was never assigned or the backend did not report the range, true otherwise.
+        */
+        bool GetAxisRange(int id, int code, AxisRange& range) const;
+
+        /**
+        * Sets the shaping of one axis of a device. The reader thread runs it
+        * once per report, and while a smoothed axis settles, and publishes the
+        * shaped value in place of the raw one, so getters and GetAllSnapshots
+        * read it at no extra cost. The event ring, subscriptions and
+        * recordings keep the raw values. Kept across reconnects of the ID.
+        * @param id the joystick ID
+        * @param code the ABS_* code
+        * @param shaping the shaping; a default AxisShaping turns it off
+        * @return false if the ID was never assigned or code is out of range, true otherwise.
+        */
+        bool SetAxisShaping(int id, int code, const AxisShaping& shaping);
+
+        /**
+        * Turns QUERY latency recording on or off. It costs one clock read per
+        * getter call, so it is off by default; APPLY latency is always recorded.
+        */
+        void SetLatencyTracking(bool enabled);
+
+        /**
+        * Replaces the udev/evdev backend, e.g. with a SyntheticBackend for
+        * tests and benchmarks. Only allowed before the first Start.
+        * @param backend the backend to read devices and hotplug from
+        * @return false if already started or backend is null, true otherwise.
+        */
+        bool SetBackend(std::unique_ptr<InputBackend> backend);
+
+        /**
+        * Chooses how the reader thread reads devices. In IO_URING mode every
+        * device that allows it keeps a read posted in an io_uring, and the
+        * reader reaps the completed reads of all devices at once and re-posts
+        * them with one io_uring_enter, instead of reading each device until
+        * EAGAIN. If the kernel does not offer io_uring or it is disabled, or
+        * the library was built without io_uring headers, Start falls back
+        * to EPOLL. Only allowed before the first Start.
+        * @return false if already started, true otherwise.
+        */
+        bool SetReaderMode(ReaderMode mode);
+
+        /**
+        * Gets the reader mode in effect, or the requested one before Start.
+        */
+        ReaderMode GetReaderMode() const;
+
+        /**
+        * Gets the reader thread's wakeup, io_uring_enter and event counters.
+        */
+        ReaderStats GetReaderStats() const;
+
+        /**
+        * Blocks until the reader thread has connected the devices that were
+        * present at Start, so their ADDED callbacks have run and services
+        * already count them.
+        * @param timeoutMs how long to wait at most; negative waits until ready
+        * @return false if Start has not succeeded or the wait timed out, true otherwise.
+        */
+        bool WaitUntilReady(int timeoutMs = -1);
+
+        /**
+        * Starts a one-shot wait checked by the reader thread; see InputWaiter.
+        * @param waiter the waiter; must not be waiting already
+        * @param id the joystick ID whose input and removal to wait for, or -1 for device changes
+        * @return false if the wait is already over: the device is not connected or waiter.Arm
+        * returned true. The waiter is then not added and never fires.
+        */
+        bool AddWaiter(InputWaiter& waiter, int id);
+
+        /**
+        * Cancels a wait before it fires. A waiter that is done waiting can be
+        * removed until the reader thread starts calling its Fire.
+        * @return false if the waiter was not waiting, or already fired or is firing.
+        */
+        bool RemoveWaiter(InputWaiter& waiter);
+
+#ifdef __cpp_impl_coroutine
+        /**
+        * Awaits the next device connecting; see JoystickCoroutines.hpp.
+        * @param executor where to resume the coroutine; nullptr resumes it on the reader thread.
+        */
+        DeviceChangeAwaiter DeviceAdded(CoroutineExecutor *executor = nullptr);
+#endif
+
+        /**
+        * Starts recording every device's descriptor and raw event stream to
+        * a file that InputReplayer can play back. Devices already connected
+        * are recorded with their current state.
+        * @param path the file to create
+        * @return false if already recording or the file cannot be created, true otherwise.
+        */
+        bool StartRecording(const char *path);
+
+        /**
+        * Finishes the recording started by StartRecording.
+        * @return false if not recording or the file could not be completed, true otherwise.
+        */
+        bool StopRecording();
+#endif
+
     private:
         Enumerator();
 
         void RegisterInstance(DeviceChangeCallback callback);
 
 #ifdef __linux__
-        void udev_thread();
-        void evdev_thread();
+        /**
+        * Registers a callback for some descriptors only. Each change is routed
+        * through a hash of its descriptor, so the callback never sees other
+        * devices. May be called again later to add descriptors.
+        * @param callback the callback
+        * @param descriptors the devices to route to it; empty for every device
+        */
+        void RegisterInstance(DeviceChangeCallback callback, const std::vector<JoystickDescriptor>& descriptors);
+
+        void reader_thread();
+        void hotplug_filter();
+        void hotplug_rescan();
+        void hotplug_scan();
+        void hotplug_receive();
+        int device_lookup(const char *path, const JoystickDescriptor& descriptor, const std::string& key) const;
+        int device_allocate();
+        void device_connect(int id, JoystickData& jsData, std::unique_ptr<InputDevice> device, const char *path);
+        void device_read(int id, bool hangup);
+        void device_remove(int id, JoystickData& jsData);
+        void ring_reap();
+        void device_publish(int id, JoystickData& jsData, const ShapingTable *shaping);
+        void settle_arm();
+        void settle_tick();
+        void record_connect(int id, const JoystickData& jsData);
+        void record_disconnect(int id);
+        void notify_device_change(const DeviceStateChange& dsc);
+        void waiter_input(int id, JoystickData& jsData);
+        void waiter_notify(const DeviceStateChange& dsc);
+        static void waiter_unlink(InputWaiter *&head, InputWaiter& waiter);
+        template <typename Done>
+        int waiter_take(InputWaiter *&head, Done done);
+        void waiter_fire();
+        void announce_devices(const DeviceChangeCallback& callback, const std::unordered_set<uint32_t> *keys);
 #endif
 
         EnumeratorImpl *impl;
         std::vector<DeviceChangeCallback> callbacks;
         bool started;
-        int connectedJoysticks;
-        int nextJoystickID;
+        std::atomic<int> connectedJoysticks;
+        std::atomic<int> nextJoystickID;
     };
 }
 
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <linux/input.h>
+
+namespace JoystickLibrary
+{
+    /**
+    * A consumer's read position in an EventRing.
+    */
+    struct EventCursor
+    {
+        uint64_t position;  /**< Sequence number of the next event to read.            */
+        uint64_t lost;      /**< Events overwritten before this cursor got to them.     */
+        uint64_t epoch;     /**< Ring epoch the cursor was created in.                  */
+    };
+
+    /**
+    * Fixed-capacity, single-producer ring of raw input_events with their
+    * kernel timestamps. The reader thread appends every event it reads and
+    * never waits; each consumer keeps its own EventCursor and copies the
+    * events out. Like SeqLock, slots are kept as relaxed atomic words so
+    * copying one while the reader overwrites it is well defined; such a
+    * torn copy is detected and discarded, so the ring holds CAPACITY - 1
+    * readable events. A consumer that falls further behind skips ahead and
+    * has the gap counted in EventCursor::lost.
+    *
+    * When a full device table hands a retired ID to a different device, the
+    * ring starts a new epoch. Cursors created before then go stale: Read
+    * returns nothing for them and IsCurrent turns false, so consumers
+    * recreate their cursors on the ADDED change for that ID.
+    */
+    class EventRing
+    {
+    public:
+        static const size_t CAPACITY = 1024;
+
+        EventRing()
+        {
+            head.store(0, std::memory_order_relaxed);
+            epoch.store(0, std::memory_order_relaxed);
+            epochStart.store(0, std::memory_order_relaxed);
+            for (auto& slot : slots)
+            {
+                for (auto& word : slot)
+                    word.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        EventRing(EventRing const&) = delete;
+        void operator=(EventRing const&) = delete;
+
+        /**
+        * Appends an event. Only the reader thread may call this.
+        */
+        void Push(const struct input_event& ev)
+        {
+            uint64_t buffer[WORDS] = { };
+            memcpy(buffer, &ev, sizeof(struct input_event));
+
+            // a consumer that sees any of these words also sees the head they overwrite at
+            uint64_t h = head.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORDS; i++)
+                slots[h & MASK][i].store(buffer[i], std::memory_order_relaxed);
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        /**
+        * Starts a new epoch for another device: cursors created so far go
+        * stale and new ones never reach the events pushed before. Only the
+        * reader thread may call this.
+        */
+        void Reset()
+        {
+            // ordered before the slots of later pushes by the fence in Push
+            epochStart.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            epoch.store(epoch.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+        * Checks whether a cursor still reads the device it was created for.
+        * @return false if the ring started a new epoch since, true otherwise.
+        */
+        bool IsCurrent(const EventCursor& cursor) const
+        {
+            return cursor.epoch == epoch.load(std::memory_order_acquire);
+        }
+
+        /**
+        * Gets the sequence number the next pushed event will have.
+        */
+        uint64_t GetHead() const
+        {
+            return head.load(std::memory_order_acquire);
+        }
+
+        /**
+        * Creates a cursor that starts with the next event pushed.
+        */
+        EventCursor NewCursor() const
+        {
+            uint64_t e = epoch.load(std::memory_order_acquire);
+            EventCursor cursor = { GetHead(), 0, e };
+            return cursor;
+        }
+
+        /**
+        * Creates a cursor that starts with the oldest event still held.
+        */
+        EventCursor OldestCursor() const
+        {
+            uint64_t e = epoch.load(std::memory_order_acquire);
+            uint64_t start = epochStart.load(std::memory_order_relaxed);
+            uint64_t oldest = Oldest(GetHead());
+            EventCursor cursor = { oldest > start ? oldest : start, 0, e };
+            return cursor;
+        }
+
+        /**
+        * Copies out the unread events at the cursor.
+        * @param cursor the consumer's cursor; skipped forward past events overrun before or during the copy
+        * @param events caller-provided buffer to fill, oldest event first
+        * @param capacity the number of entries in events
+        * @return the number of events copied; 0 if caught up or the cursor is stale.
+        */
+        size_t Read(EventCursor& cursor, struct input_event *events, size_t capacity) const
+        {
+            while (true)
+            {
+                if (!IsCurrent(cursor))
+                    return 0;
+
+                uint64_t h = GetHead();
+                Skip(cursor, h);
+
+                size_t available = static_cast<size_t>(h - cursor.position);
+                size_t count = available < capacity ? available : capacity;
+                for (size_t n = 0; n < count; n++)
+                {
+                    uint64_t buffer[WORDS];
+                    const std::atomic<uint64_t> *slot = slots[(cursor.position + n) & MASK];
+                    for (size_t i = 0; i < WORDS; i++)
+                        buffer[i] = slot[i].load(std::memory_order_relaxed);
+                    memcpy(&events[n], buffer, sizeof(struct input_event));
+                }
+
+                // events the producer started overwriting meanwhile may be torn; drop them,
+                // and everything if some may belong to the device of a new epoch
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (epoch.load(std::memory_order_relaxed) != cursor.epoch)
+                    return 0;
+                uint64_t start = cursor.position;
+                Skip(cursor, GetHead());
+                size_t torn = static_cast<size_t>(cursor.position - start);
+                if (torn > 0 && torn >= count)
+                    continue;
+
+                count -= torn;
+                if (torn)
+                    memmove(events, events + torn, count * sizeof(struct input_event));
+                cursor.position += count;
+                return count;
+            }
+        }
+
+    private:
+        static const uint64_t MASK = CAPACITY - 1;
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "EventRing capacity must be a power of two");
+
+        static const size_t WORDS = (sizeof(struct input_event) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        // the producer may be overwriting the slot of h - CAPACITY, so the oldest readable event is one later
+        static uint64_t Oldest(uint64_t h)
+        {
+            return h >= CAPACITY ? h - CAPACITY + 1 : 0;
+        }
+
+        // moves a cursor that fell behind up to the oldest event still readable at head h
+        static void Skip(EventCursor& cursor, uint64_t h)
+        {
+            uint64_t oldest = Oldest(h);
+            if (cursor.position < oldest)
+            {
+                cursor.lost += oldest - cursor.position;
+                cursor.position = oldest;
+            }
+        }
+
+        std::atomic<uint64_t> head;
+        // bumped by Reset; epochStart is the head at the time
+        std::atomic<uint64_t> epoch;
+        std::atomic<uint64_t> epochStart;
+        std::atomic<uint64_t> slots[CAPACITY][WORDS];
+    };
+}
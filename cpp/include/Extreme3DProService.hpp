@@ -1,6 +1,6 @@
 #pragma once
 
-#include "JoystickService.hpp"
+#include "JoystickServiceT.hpp"
 
 namespace JoystickLibrary
 {
@@ -20,7 +20,43 @@ namespace JoystickLibrary
         Button12 = 11
     };
 
-    class Extreme3DProService : public JoystickService
+    /**
+    * All inputs of one Extreme 3D Pro, read at the same moment.
+    * Axis values use the same ranges as the individual getters.
+    */
+    struct Extreme3DProSnapshot
+    {
+        int x;
+        int y;
+        int zRot;
+        int slider;
+        POV pov;
+        uint32_t buttons;   /**< Bit n is set while Extreme3DProButton n is pressed. */
+
+        bool GetButton(Extreme3DProButton button) const
+        {
+            return ((buttons >> static_cast<int>(button)) & 1) != 0;
+        }
+    };
+
+#ifndef _WIN32
+    struct Extreme3DProProfile
+    {
+        typedef DescriptorList<Descriptor<0x046D, 0xC215>> Descriptors;
+        typedef CenteredAxis<ABS_X, 0, 1023> X;
+        typedef CenteredAxis<ABS_Y, 0, 1023, -1> Y;
+        typedef CenteredAxis<ABS_RZ, 0, 255> ZRot;
+        typedef PercentAxis<ABS_THROTTLE, 255, 0> Slider;
+        typedef HatAxis<ABS_HAT0X> Hat;
+        typedef ButtonRange<BTN_TRIGGER, 12> Buttons;
+    };
+
+    typedef JoystickServiceT<Extreme3DProProfile> Extreme3DProServiceBase;
+#else
+    typedef JoystickService Extreme3DProServiceBase;
+#endif
+
+    class Extreme3DProService : public Extreme3DProServiceBase
     {
     public:
         const std::vector<JoystickDescriptor> EXTREME_3D_PRO_IDS {
@@ -104,8 +140,31 @@ namespace JoystickLibrary
         */
         bool GetPOV(int joystickID, POV& pov);
 
+        /**
+        * Gets every axis, the POV hat and all buttons of the specified joystick ID
+        * from a single consistent read of the device state.
+        * @param joystickID the joystick ID
+        * @param snapshot A reference in which to save the values. Will not be modified if call fails.
+        * @return false if invalid joystickID or disconnected joystick, true otherwise.
+        */
+        bool GetSnapshot(int joystickID, Extreme3DProSnapshot& snapshot);
+
+#ifndef _WIN32
+        /**
+        * Decodes one entry of an Enumerator::GetAllSnapshots frame.
+        * @param device the captured device
+        * @param snapshot A reference in which to save the values. Will not be modified if call fails.
+        * @return false if the device is not an Extreme 3D Pro, true otherwise.
+        */
+        bool GetSnapshot(const DeviceSnapshot& device, Extreme3DProSnapshot& snapshot);
+#endif
+
     protected:
+#ifdef _WIN32
         void OnDeviceChanged(DeviceStateChange ds);
+#else
+        void FillSnapshot(const JoystickState& state, Extreme3DProSnapshot& snapshot) const;
+#endif
     };
 }
 
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "JoystickService.hpp"
+#include "ProfileRegistry.hpp"
+
+#ifndef _WIN32
+namespace JoystickLibrary
+{
+    /**
+    * Reads any controller that has a mapping in its ProfileRegistry through
+    * one gamepad layout, so supporting a new model takes a mapping string
+    * instead of a new service. Only devices with a mapping are routed here.
+    *
+    * Sticks read -100..100 with pushing forwards positive, like
+    * Xbox360Service; triggers read 0..100.
+    */
+    class GameControllerService : public JoystickService
+    {
+    public:
+        static GameControllerService& GetInstance()
+        {
+            static GameControllerService instance;
+            return instance;
+        }
+
+        GameControllerService();
+        GameControllerService(GameControllerService const&) = delete;
+        void operator=(GameControllerService const&) = delete;
+        ~GameControllerService();
+
+        /**
+        * Loads one mapping string. Replacing the mapping of a connected
+        * controller takes effect when it reconnects.
+        * @param mapping the mapping string
+        * @return false if the mapping is malformed, for another platform or has no vendor/product, true otherwise.
+        */
+        bool AddMapping(const std::string& mapping);
+
+        /**
+        * Loads mapping strings, one per line.
+        * @return the number of mappings loaded.
+        */
+        int AddMappings(const std::string& mappings);
+
+        /**
+        * Loads mapping strings from a file such as gamecontrollerdb.txt.
+        * @return the number of mappings loaded, or -1 if the file cannot be read.
+        */
+        int AddMappingsFromFile(const char *path);
+
+        const ProfileRegistry& GetRegistry() const { return registry; }
+
+        /**
+        * Gets an axis of the specified joystick ID.
+        * @param joystickID the joystick ID
+        * @param axis the axis to query
+        * @param value A reference in which to save the value. Will not be modified if call fails.
+        * @return false if invalid joystickID, disconnected joystick or unmapped axis, true otherwise.
+        */
+        bool GetAxis(int joystickID, ControllerAxis axis, int& value);
+
+        /**
+        * Gets a button of the specified joystick ID.
+        * @param joystickID the joystick ID
+        * @param button the button to query
+        * @param buttonVal A reference in which to save the value. Will not be modified if call fails.
+        * @return false if invalid joystickID, disconnected joystick or unmapped button, true otherwise.
+        */
+        bool GetButton(int joystickID, ControllerButton button, bool& buttonVal);
+
+        /**
+        * Gets the name given by the mapping of the specified joystick ID.
+        * @return false if invalid joystickID or disconnected joystick, true otherwise.
+        */
+        bool GetName(int joystickID, std::string& name);
+
+    protected:
+        bool GetDescriptors(std::vector<JoystickDescriptor>& descriptors) const override;
+        void OnDeviceChanged(DeviceStateChange ds) override;
+
+    private:
+        struct DeviceMapping;
+        typedef std::unordered_map<int, std::shared_ptr<const DeviceMapping>> MappingTable;
+
+        std::shared_ptr<const DeviceMapping> FindMapping(int joystickID) const;
+        void Route(const std::vector<JoystickDescriptor>& added);
+
+        ProfileRegistry registry;
+        // copy-on-write; replaced under mappingLock, read with atomic_load
+        std::shared_ptr<const MappingTable> mappings;
+        std::mutex mappingLock;
+    };
+}
+#endif
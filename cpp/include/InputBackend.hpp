@@ -0,0 +1,244 @@
+#pragma once
+
+#include "Types.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace JoystickLibrary
+{
+    /**
+    * Result of reading one event from an InputDevice.
+    */
+    enum class ReadStatus
+    {
+        SUCCESS,    /**< An event was read.                                                     */
+        SYNC,       /**< Events were dropped; read with sync set to get the delta to catch up.  */
+        AGAIN,      /**< Nothing queued right now; wait for the fd to become readable.          */
+        FAILED      /**< The device is gone or broken and should be disconnected.               */
+    };
+
+    /**
+    * A hotplug notification from an InputBackend.
+    */
+    struct HotplugEvent
+    {
+        enum class Action
+        {
+            ADDED, REMOVED
+        };
+
+        Action action;
+        std::string path;
+    };
+
+    /**
+    * Which devices the enumerator wants, so a backend can skip the rest
+    * without opening them. A default filter wants every device.
+    */
+    struct DeviceFilter
+    {
+        DeviceFilter()
+            : joysticksOnly(false),
+              everyDescriptor(true)
+        {
+        }
+
+        bool joysticksOnly;                         /**< Only devices identified as joysticks.             */
+        bool everyDescriptor;                       /**< Any vendor and product; otherwise only descriptors. */
+        std::unordered_set<uint32_t> descriptors;   /**< DescriptorKeys of the wanted devices.             */
+
+        bool Matches(const JoystickDescriptor& descriptor) const
+        {
+            return everyDescriptor || descriptors.count(DescriptorKey(descriptor)) != 0;
+        }
+    };
+
+    /**
+    * One opened input device. Only the enumerator's reader thread uses it.
+    */
+    class InputDevice
+    {
+    public:
+        /**
+        * The most bytes one Deliver call hands over.
+        */
+        static const size_t MAX_DELIVERY = 64 * sizeof(struct input_event);
+
+        virtual ~InputDevice() { }
+
+        /**
+        * Gets an fd that polls readable while events are queued.
+        */
+        virtual int GetFd() const = 0;
+
+        virtual JoystickDescriptor GetDescriptor() const = 0;
+
+        /**
+        * Fills state with the device's current axis and button values.
+        */
+        virtual void Seed(JoystickState& state) = 0;
+
+        /**
+        * Gets the minimum and maximum an axis reports.
+        * @param code the ABS_* code
+        * @param range A reference in which to save the range. Will not be modified if call fails.
+        * @return false if the axis or its range is unknown, true otherwise.
+        */
+        virtual bool GetAxisRange(int code, AxisRange& range) const
+        {
+            (void) code;
+            (void) range;
+            return false;
+        }
+
+        /**
+        * Gets an identity of the physical device that survives unplugging it,
+        * such as its serial number or the port it is plugged into. The
+        * enumerator uses it to give a reconnected device its old ID even if
+        * it comes back under another path.
+        * @param key A reference in which to save the key. Will not be modified if call fails.
+        * @return false if the device has no stable identity, true otherwise.
+        */
+        virtual bool GetStableKey(std::string& key) const
+        {
+            (void) key;
+            return false;
+        }
+
+        /**
+        * Reads the next event without blocking.
+        * @param ev A reference in which to save the event. Only valid on SUCCESS or SYNC.
+        * @param sync true while catching up after a SYNC result; false otherwise.
+        * @return SUCCESS, SYNC, AGAIN or FAILED; in sync mode, SYNC means ev is part of the delta
+        * and anything else means the delta is complete.
+        */
+        virtual ReadStatus Next(struct input_event& ev, bool sync) = 0;
+
+        /**
+        * Hands reading the fd over to the caller, e.g. to keep reads posted
+        * in an io_uring. From then on Next never reads the fd itself: it
+        * returns the events of the bytes passed to Deliver, then AGAIN.
+        * @return the fd to read raw struct input_event records from, or -1
+        * if the device cannot be read that way and stays with Next.
+        */
+        virtual int TakeReads()
+        {
+            return -1;
+        }
+
+        /**
+        * Passes bytes read from the fd after TakeReads. Only called once Next
+        * returned AGAIN since the last delivery.
+        * @param bytes what the read returned; may end in part of a record
+        * @param size at most MAX_DELIVERY
+        */
+        virtual void Deliver(const void *bytes, size_t size)
+        {
+            (void) bytes;
+            (void) size;
+        }
+    };
+
+    /**
+    * Source of input devices and hotplug notifications for the Enumerator.
+    * The default backend reads real hardware through udev and libevdev;
+    * SyntheticBackend and PipeBackend feed scripted or piped events instead.
+    */
+    class InputBackend
+    {
+    public:
+        virtual ~InputBackend() { }
+
+        /**
+        * Prepares the backend. Called once from Enumerator::Start.
+        * @return false if the backend cannot be used.
+        */
+        virtual bool Start() = 0;
+
+        /**
+        * Gets an fd that polls readable while hotplug notifications are pending; -1 if there are none.
+        */
+        virtual int GetFd() const = 0;
+
+        /**
+        * Narrows the devices Scan and Receive report. Backends that cannot
+        * tell devices apart before opening them may ignore it, since the
+        * enumerator routes by descriptor anyway.
+        */
+        virtual void SetFilter(const DeviceFilter& filter)
+        {
+            (void) filter;
+        }
+
+        /**
+        * Lists the paths of the devices present right now.
+        */
+        virtual void Scan(std::vector<std::string>& paths) = 0;
+
+        /**
+        * Takes the pending hotplug notifications.
+        */
+        virtual void Receive(std::vector<HotplugEvent>& events) = 0;
+
+        /**
+        * Opens a device found by Scan or Receive.
+        * @return the device, or nullptr if the path is not a usable input device.
+        */
+        virtual std::unique_ptr<InputDevice> Open(const char *path) = 0;
+    };
+
+    /**
+    * Pending hotplug notifications behind an eventfd, for backends that
+    * generate their own instead of getting them from the kernel.
+    */
+    class HotplugQueue
+    {
+    public:
+        HotplugQueue();
+        ~HotplugQueue();
+        HotplugQueue(HotplugQueue const&) = delete;
+        void operator=(HotplugQueue const&) = delete;
+
+        int GetFd() const { return notify_fd; }
+        void Post(HotplugEvent::Action action, const std::string& path);
+        void Receive(std::vector<HotplugEvent>& events);
+
+    private:
+        std::mutex lock;
+        std::vector<HotplugEvent> pending;
+        int notify_fd;
+    };
+
+    /**
+    * Real hardware: udev enumeration and hotplug, evdev devices probed through
+    * libevdev and read in bulk with read().
+    * The filter is applied to udev's properties (ID_INPUT_JOYSTICK, ID_VENDOR_ID,
+    * ID_MODEL_ID), so unwanted devices such as keyboards are never opened.
+    */
+    class UdevBackend : public InputBackend
+    {
+    public:
+        UdevBackend();
+        ~UdevBackend();
+        UdevBackend(UdevBackend const&) = delete;
+        void operator=(UdevBackend const&) = delete;
+
+        bool Start() override;
+        int GetFd() const override;
+        void SetFilter(const DeviceFilter& filter) override;
+        void Scan(std::vector<std::string>& paths) override;
+        void Receive(std::vector<HotplugEvent>& events) override;
+        std::unique_ptr<InputDevice> Open(const char *path) override;
+
+    private:
+        bool accepts(struct udev_device *dev) const;
+
+        DeviceFilter filter;
+        struct udev *udev;
+        struct udev_monitor *udev_monitor;
+        int udev_mon_fd;
+    };
+}
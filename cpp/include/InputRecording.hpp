@@ -0,0 +1,213 @@
+#pragma once
+
+#include "SyntheticBackend.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <thread>
+
+namespace JoystickLibrary
+{
+    /*
+    * Recording file layout; all fields little-endian, as written by the host:
+    *
+    *   RecordingHeader
+    *   RecordedEvent     x trailer.recordCount, in reader-thread order
+    *   RecordedDevice    x trailer.deviceCount, indexed by RecordedEvent::device
+    *   RecordingIndex    x trailer.indexCount, one per INDEX_STRIDE records
+    *   RecordingTrailer
+    */
+
+    const char RECORDING_MAGIC[8] = { 'J', 'S', 'R', 'E', 'C', '0', '0', '1' };
+    const char RECORDING_END_MAGIC[8] = { 'J', 'S', 'R', 'E', 'C', 'E', 'N', 'D' };
+
+    // RecordedEvent::type values beyond the EV_* range
+    const uint8_t RECORD_CONNECT = 0xFF;        /**< Device plugged in; its seed state follows as events. */
+    const uint8_t RECORD_DISCONNECT = 0xFE;     /**< Device unplugged.                                     */
+
+    struct RecordingHeader
+    {
+        char magic[8];
+        uint32_t recordSize;        /**< sizeof(RecordedEvent), to reject foreign layouts.   */
+        uint32_t deviceSize;        /**< sizeof(RecordedDevice).                             */
+        uint64_t startTime;         /**< CLOCK_MONOTONIC time recording started, in ns.      */
+    };
+
+    struct RecordedEvent
+    {
+        uint64_t time;              /**< Event timestamp on CLOCK_MONOTONIC, in ns.          */
+        int32_t value;
+        uint16_t code;
+        uint8_t type;               /**< EV_*, RECORD_CONNECT or RECORD_DISCONNECT.          */
+        uint8_t device;             /**< Index into the device table.                        */
+    };
+
+    struct RecordedDevice
+    {
+        JoystickDescriptor descriptor;
+        char path[64];
+        JoystickState initial;      /**< Axes and buttons the device had when first seen.    */
+    };
+
+    struct RecordingIndex
+    {
+        uint64_t time;              /**< Time of the indexed record, in ns.                  */
+        uint64_t record;            /**< Record number.                                      */
+    };
+
+    struct RecordingTrailer
+    {
+        uint64_t recordCount;
+        uint64_t deviceOffset;
+        uint64_t indexOffset;
+        uint32_t deviceCount;
+        uint32_t indexCount;
+        char magic[8];
+    };
+
+    static_assert(sizeof(RecordedEvent) == 16, "RecordedEvent must stay 16 bytes");
+
+    /**
+    * Writes every device's descriptor and timestamped event stream to a
+    * recording file. Called from the enumerator's reader thread, which only
+    * appends to a buffer; full buffers are handed to a writer thread, so
+    * file I/O never holds up input. See Enumerator::StartRecording.
+    */
+    class InputRecorder
+    {
+    public:
+        static const int MAX_DEVICES = 256;
+        static const uint64_t INDEX_STRIDE = 4096;
+
+        InputRecorder();
+        ~InputRecorder();
+        InputRecorder(InputRecorder const&) = delete;
+        void operator=(InputRecorder const&) = delete;
+
+        /**
+        * Creates the file and writes its header.
+        * @return false if the file cannot be created, true otherwise.
+        */
+        bool Open(const char *path);
+
+        /**
+        * Records a device connecting, followed by its current state.
+        * Ignored if the device is already recorded as connected. An ID that
+        * comes back with another descriptor or stable key is a different
+        * device and gets a new device table entry.
+        */
+        void RecordConnect(int id, const JoystickDescriptor& descriptor, const std::string& stableKey,
+            const char *path, const JoystickState& state);
+
+        void RecordDisconnect(int id);
+
+        /**
+        * Records one event. Ignored for devices not recorded as connected.
+        */
+        void RecordEvent(int id, const struct input_event& ev);
+
+        /**
+        * Waits for the writer thread, then writes the rest of the records,
+        * the device table, index and trailer and closes the file.
+        * @return false if any write failed, true otherwise.
+        */
+        bool Close();
+
+    private:
+        void Append(const RecordedEvent& record);
+        void WriteBatches();
+
+        std::mutex lock;
+        FILE *file;
+        bool failed;
+        uint64_t recordCount;
+        // filled by the reader thread; swapped with `writing` once full and the writer is idle
+        std::vector<RecordedEvent> buffer;
+        // owned by the writer thread while non-empty
+        std::vector<RecordedEvent> writing;
+        std::thread writer;
+        std::condition_variable writerCondition;
+        bool closing;
+        std::vector<RecordedDevice> devices;
+        std::vector<std::string> stableKeys;
+        std::vector<bool> connected;
+        std::map<int, int> slots;
+        std::vector<RecordingIndex> index;
+    };
+
+    enum class ReplaySpeed
+    {
+        REAL_TIME,              /**< Keep the recorded gaps; timestamps are shifted to now. */
+        AS_FAST_AS_POSSIBLE     /**< No gaps; events are stamped when fed.                  */
+    };
+
+    /**
+    * Plays a recording back through a SyntheticBackend, so it reaches
+    * services through the same enumerator reader thread as live input.
+    * The file is memory-mapped and read in place.
+    */
+    class InputReplayer
+    {
+    public:
+        InputReplayer();
+        ~InputReplayer();
+        InputReplayer(InputReplayer const&) = delete;
+        void operator=(InputReplayer const&) = delete;
+
+        /**
+        * Maps and validates a recording.
+        * @return false if the file is missing, truncated or not a recording, true otherwise.
+        */
+        bool Open(const char *path);
+
+        /**
+        * Creates the backend to install with Enumerator::SetBackend before
+        * the first Start. The replayer feeds it, so it must not be replaced.
+        */
+        std::unique_ptr<InputBackend> CreateBackend();
+
+        /**
+        * Feeds the whole recording on the calling thread and waits until the
+        * reader thread has consumed it. Gives up if the reader thread makes no
+        * progress for two seconds, e.g. because the enumerator is not running.
+        * @return false if no recording or backend, if stopped early or if the reader stalled; true otherwise.
+        */
+        bool Play(ReplaySpeed speed);
+
+        /**
+        * Makes a running Play return early.
+        */
+        void Stop();
+
+        uint64_t GetRecordCount() const { return recordCount; }
+        int GetDeviceCount() const { return deviceCount; }
+
+        /**
+        * Gets the recording's length from the first to the last record, in ns.
+        */
+        uint64_t GetDuration() const;
+
+        /**
+        * Finds the first record at or after a time, using the index. Records
+        * are in arrival order, so times across devices are only nearly sorted.
+        * @param time offset from the first record, in ns
+        * @return the record number; GetRecordCount() if past the end.
+        */
+        uint64_t FindRecord(uint64_t time) const;
+
+    private:
+        void Unmap();
+
+        void *mapping;
+        size_t mappingSize;
+        const RecordedEvent *records;
+        uint64_t recordCount;
+        const RecordedDevice *devices;
+        int deviceCount;
+        const RecordingIndex *index;
+        uint32_t indexCount;
+        SyntheticBackend *backend;
+        std::atomic<bool> stopping;
+    };
+}
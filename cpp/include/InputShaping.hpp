@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <linux/input.h>
+
+struct JoystickState;
+struct AxisRange;
+
+namespace JoystickLibrary
+{
+    enum class Smoothing
+    {
+        NONE,       /**< Follow the input directly.                                          */
+        EMA,        /**< Exponential moving average with time constant emaTime.              */
+        ONE_EURO    /**< One-euro filter: smooth at rest, responsive while moving quickly.   */
+    };
+
+    /**
+    * Per-axis input shaping, applied in this order: deadzones, expo curve,
+    * smoothing, slew limit. Amounts are fractions of the axis's half range,
+    * so 1.0 is the distance from the center to either end. A default
+    * AxisShaping passes the axis through unchanged.
+    */
+    struct AxisShaping
+    {
+        AxisShaping()
+            : rangeMinimum(0),
+              rangeMaximum(0),
+              deadzone(0.0f),
+              outerDeadzone(0.0f),
+              radialCode(-1),
+              expo(0.0f),
+              smoothing(Smoothing::NONE),
+              emaTime(0.02f),
+              minCutoff(1.0f),
+              beta(0.0f),
+              derivativeCutoff(1.0f),
+              slewRate(0.0f)
+        {
+        }
+
+        int rangeMinimum;           /**< Raw range; equal to rangeMaximum to use the range the device reports. */
+        int rangeMaximum;
+        float deadzone;             /**< Inputs closer to the center read as centered.                 */
+        float outerDeadzone;        /**< Inputs this close to an end read as fully deflected.          */
+        int radialCode;             /**< Other ABS_* axis of the stick for a radial deadzone; -1 for axial. */
+        float expo;                 /**< 0 is linear, 1 is cubic: (1 - expo) * x + expo * x^3.         */
+        Smoothing smoothing;
+        float emaTime;              /**< EMA time constant, in seconds.                                */
+        float minCutoff;            /**< One-euro cutoff at rest, in Hz.                               */
+        float beta;                 /**< One-euro cutoff increase per unit of speed.                   */
+        float derivativeCutoff;     /**< One-euro cutoff for the speed estimate, in Hz.                */
+        float slewRate;             /**< Maximum change per second; 0 for no limit.                    */
+
+        bool IsIdentity() const
+        {
+            return deadzone <= 0.0f && outerDeadzone <= 0.0f && expo == 0.0f && smoothing == Smoothing::NONE
+                && slewRate <= 0.0f;
+        }
+    };
+
+    /**
+    * Shaping of every axis of one device. Immutable once published; changes
+    * replace the whole table.
+    */
+    struct ShapingTable
+    {
+        uint64_t version;           /**< Differs between every table a device is given. */
+        uint64_t mask;              /**< Bit n is set if ABS_* code n is shaped.         */
+        AxisShaping axes[ABS_CNT];
+    };
+
+    /**
+    * The filter memory of one device's shaping pipeline. Owned by the
+    * enumerator's reader thread, which runs it once per report.
+    */
+    class InputShaper
+    {
+    public:
+        InputShaper();
+
+        /**
+        * Forgets filter history, e.g. after a reconnect.
+        */
+        void Reset();
+
+        /**
+        * Shapes every axis in table from the raw state into shaped.
+        * @param table the shaping to apply
+        * @param ranges the ranges the device reported, indexed by ABS_* code
+        * @param raw the device state as read
+        * @param now the CLOCK_MONOTONIC time, in ns
+        * @param shaped A reference in which to save the shaped axes; other fields are left alone.
+        * @return true while a smoothed or slew-limited axis has not caught up with its input.
+        */
+        bool Update(const ShapingTable& table, const AxisRange *ranges, const JoystickState& raw, uint64_t now,
+            JoystickState& shaped);
+
+    private:
+        struct Filter
+        {
+            float value;        // output so far, normalized
+            float input;        // last shaped input, for the one-euro speed
+            float speed;        // smoothed speed, for the one-euro cutoff
+            bool primed;
+        };
+
+        uint64_t version;   // of the table the filters belong to
+        uint64_t lastTime;
+        Filter filters[ABS_CNT];
+    };
+}
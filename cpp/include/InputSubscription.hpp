@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace JoystickLibrary
+{
+    /**
+    * A single input change delivered to a subscriber.
+    */
+    struct InputEvent
+    {
+        enum class Type : int
+        {
+            AXIS = 1 << 0,      /**< An absolute axis moved. value is the raw axis value.     */
+            BUTTON = 1 << 1,    /**< A button changed. value is 1 if pressed, 0 otherwise.    */
+            POV = 1 << 2        /**< A hat changed. value is the POV direction as an int.     */
+        };
+
+        Type type;
+        int id;                 /**< The joystick ID.                                        */
+        int code;               /**< ABS_* or BTN_* code; the hat's X axis code for POV.     */
+        int value;
+        uint64_t eventTime;     /**< Kernel timestamp of the change, in ns.                  */
+    };
+
+    /**
+    * What a full subscription queue does with a new event.
+    */
+    enum class OverflowPolicy
+    {
+        COALESCE,       /**< Overwrite the queued event for the same control, else drop the oldest. */
+        DROP_OLDEST     /**< Always drop the oldest queued event.                                    */
+    };
+
+    struct SubscriptionOptions
+    {
+        SubscriptionOptions()
+            : joystickID(-1),
+              types(static_cast<int>(InputEvent::Type::AXIS) | static_cast<int>(InputEvent::Type::BUTTON)
+                  | static_cast<int>(InputEvent::Type::POV)),
+              capacity(64),
+              policy(OverflowPolicy::COALESCE)
+        {
+        }
+
+        int joystickID;             /**< Only deliver events from this joystick; -1 for all.  */
+        int types;                  /**< Bitwise OR of the InputEvent::Type values to deliver. */
+        int capacity;               /**< Maximum number of queued events.                      */
+        OverflowPolicy policy;
+    };
+
+    /**
+    * Bounded queue of input changes for one consumer.
+    * Filled from the enumerator's reader thread; the queue storage is allocated
+    * once up front, so delivering an event never allocates.
+    */
+    class InputSubscription
+    {
+    public:
+        explicit InputSubscription(const SubscriptionOptions& options);
+        InputSubscription(InputSubscription const&) = delete;
+        void operator=(InputSubscription const&) = delete;
+
+        /**
+        * Takes the oldest queued event, blocking until one arrives.
+        * @param event A reference in which to save the event. Will not be modified if call fails.
+        * @param timeoutMs how long to wait in milliseconds; negative waits forever.
+        * @return false on timeout or once the subscription is closed and drained, true otherwise.
+        */
+        bool Wait(InputEvent& event, int timeoutMs = -1);
+
+        /**
+        * Takes the oldest queued event without blocking.
+        * @param event A reference in which to save the event. Will not be modified if call fails.
+        * @return false if the queue is empty, true otherwise.
+        */
+        bool TryPop(InputEvent& event);
+
+        /**
+        * Gets how many events were discarded because the queue was full.
+        */
+        uint64_t GetDropped() const;
+
+        /**
+        * Wakes any waiter and stops accepting new events.
+        */
+        void Close();
+
+        const SubscriptionOptions& GetOptions() const { return options; }
+
+        // reader thread side //
+        bool Accepts(int id, InputEvent::Type type) const;
+        void Push(const InputEvent& event);
+        void Flush();
+
+    private:
+        bool Pop(InputEvent& event);
+
+        SubscriptionOptions options;
+        std::vector<InputEvent> queue;
+        size_t head;
+        size_t count;
+        uint64_t dropped;
+        bool pending;
+        bool closed;
+        mutable std::mutex lock;
+        std::condition_variable ready;
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Types.hpp"
+
+namespace JoystickLibrary
+{
+    /**
+    * A one-shot wait on the enumerator's reader thread, such as a suspended
+    * coroutine; see JoystickCoroutines.hpp. Waiters are linked into the
+    * enumerator intrusively, so waiting never allocates; the waiter must
+    * stay alive until it fires or is removed.
+    *
+    * The reader thread checks waiters under the enumerator's waiter lock,
+    * so OnInput and OnDeviceChange must be quick and must not call back
+    * into the enumerator. Fire runs after the lock is released.
+    */
+    class InputWaiter
+    {
+    public:
+        InputWaiter()
+            : prev(nullptr), next(nullptr), id(-1), linked(false)
+        {
+        }
+
+        virtual ~InputWaiter() { }
+
+        InputWaiter(InputWaiter const&) = delete;
+        void operator=(InputWaiter const&) = delete;
+
+        /**
+        * Called once while the waiter is added, with the device's published
+        * state as of then; every later state reaches OnInput.
+        * @return true if the wait is already over; the waiter is then not added.
+        */
+        virtual bool Arm(const JoystickState& current)
+        {
+            (void) current;
+            return false;
+        }
+
+        /**
+        * Called after the device published a new state.
+        * @return true to end the wait.
+        */
+        virtual bool OnInput(const JoystickState& state)
+        {
+            (void) state;
+            return false;
+        }
+
+        /**
+        * Called for every device change when waiting on device changes, and
+        * for the device's removal when waiting on a device.
+        * @return true to end the wait.
+        */
+        virtual bool OnDeviceChange(const DeviceStateChange& dsc)
+        {
+            (void) dsc;
+            return false;
+        }
+
+        /**
+        * Called on the reader thread once the wait is over.
+        */
+        virtual void Fire() = 0;
+
+    private:
+        friend class Enumerator;
+
+        // guarded by the enumerator's waiter lock
+        InputWaiter *prev;
+        InputWaiter *next;
+        int id;
+        bool linked;
+    };
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+// Optional C++20 layer: awaitables for coroutine-based control code.
+//
+//   bool moved = co_await service.NextChange(id);
+//   bool pressed = co_await service.ButtonPressed(id, Extreme3DProButton::Trigger);
+//   DeviceStateChange added = co_await enumerator.DeviceAdded();
+//
+// A waiting coroutine is resumed by the enumerator's reader thread as soon
+// as the input it waits for is published, directly on that thread or
+// through a CoroutineExecutor. There is no polling, and each awaiter lives
+// in the coroutine frame and is linked into the enumerator intrusively, so
+// awaiting never allocates. Code resumed on the reader thread holds up
+// input from every device until it suspends again, like device change
+// callbacks do; hand longer work to an executor.
+
+#ifndef __cpp_impl_coroutine
+    #error JoystickCoroutines.hpp needs C++20 coroutines
+#endif
+
+#include "JoystickServiceT.hpp"
+#include <condition_variable>
+#include <coroutine>
+
+namespace JoystickLibrary
+{
+    /**
+    * Where awaiters resume their coroutines instead of the reader thread,
+    * e.g. a thread pool or an event loop. Post is called on the reader
+    * thread and should only queue the handle.
+    */
+    class CoroutineExecutor
+    {
+    public:
+        virtual ~CoroutineExecutor() { }
+        virtual void Post(std::coroutine_handle<> handle) = 0;
+    };
+
+    /**
+    * Shared part of the awaiters: suspends on AddWaiter, resumes on Fire.
+    * Each awaiter is final and calls Cancel from its own destructor, so the
+    * reader thread never checks a waiter that is partly destroyed.
+    */
+    class CoroutineWaiter : public InputWaiter
+    {
+    public:
+        CoroutineWaiter(Enumerator& enumerator, int joystickID, CoroutineExecutor *executor)
+            : enumerator(enumerator), joystickID(joystickID), executor(executor), added(false), fired(false),
+              abandoned(false)
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            this->handle = handle;
+            // once added, the reader may resume the coroutine before this returns
+            added = enumerator.AddWaiter(*this, joystickID);
+            return added;
+        }
+
+        void Fire() override
+        {
+            std::coroutine_handle<> resumed;
+            CoroutineExecutor *target;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                fired = true;
+                if (!abandoned)
+                    resumed = handle;
+                target = executor;
+                done.notify_all();
+            }
+
+            // the coroutine may destroy this awaiter from here on
+            if (!resumed)
+                return;
+            if (target)
+                target->Post(resumed);
+            else
+                resumed.resume();
+        }
+
+    protected:
+        // a coroutine destroyed while suspended must not be resumed, nor the awaiter used, later
+        void Cancel()
+        {
+            if (!added || enumerator.RemoveWaiter(*this))
+                return;
+
+            // the reader already took the waiter and is about to call Fire
+            std::unique_lock<std::mutex> guard(lock);
+            abandoned = true;
+            done.wait(guard, [this]() { return fired; });
+        }
+
+        Enumerator& enumerator;
+        int joystickID;
+        CoroutineExecutor *executor;
+        std::coroutine_handle<> handle;
+
+    private:
+        bool added;
+        std::mutex lock;
+        std::condition_variable done;
+        bool fired;
+        bool abandoned;
+    };
+
+    /**
+    * Awaits the next change to any axis or button of a device.
+    * Resumes with false if the device is not connected or disconnects first.
+    */
+    class InputChangeAwaiter final : public CoroutineWaiter
+    {
+    public:
+        InputChangeAwaiter(Enumerator& enumerator, int id, CoroutineExecutor *executor)
+            : CoroutineWaiter(enumerator, id, executor), changed(false)
+        {
+        }
+
+        ~InputChangeAwaiter()
+        {
+            Cancel();
+        }
+
+        bool await_ready() const { return joystickID < 0; }
+        bool await_resume() const { return changed; }
+
+        bool Arm(const JoystickState& current) override
+        {
+            baseline = current;
+            return false;
+        }
+
+        bool OnInput(const JoystickState& state) override
+        {
+            changed = !state.SameInputs(baseline);
+            return changed;
+        }
+
+    private:
+        JoystickState baseline;
+        bool changed;
+    };
+
+    /**
+    * Awaits a button of a device going from released to pressed; a button
+    * held when the wait starts has to be released first.
+    * Resumes with false if the device is not connected or disconnects first.
+    */
+    class ButtonPressAwaiter final : public CoroutineWaiter
+    {
+    public:
+        ButtonPressAwaiter(Enumerator& enumerator, int id, int code, CoroutineExecutor *executor)
+            : CoroutineWaiter(enumerator, id, executor), code(code), held(false), pressed(false)
+        {
+        }
+
+        ~ButtonPressAwaiter()
+        {
+            Cancel();
+        }
+
+        bool await_ready() const { return joystickID < 0; }
+        bool await_resume() const { return pressed; }
+
+        bool Arm(const JoystickState& current) override
+        {
+            held = current.GetButton(code);
+            return false;
+        }
+
+        bool OnInput(const JoystickState& state) override
+        {
+            bool down = state.GetButton(code);
+            pressed = down && !held;
+            held = down;
+            return pressed;
+        }
+
+    private:
+        int code;
+        bool held;
+        bool pressed;
+    };
+
+    /**
+    * Awaits a device change of one kind, such as the next device connecting.
+    * Resumes with the change once its callbacks have run, so services
+    * already know a new device.
+    */
+    class DeviceChangeAwaiter final : public CoroutineWaiter
+    {
+    public:
+        DeviceChangeAwaiter(Enumerator& enumerator, DeviceStateChange::State state, CoroutineExecutor *executor)
+            : CoroutineWaiter(enumerator, -1, executor), state(state)
+        {
+            change.id = -1;
+        }
+
+        ~DeviceChangeAwaiter()
+        {
+            Cancel();
+        }
+
+        bool await_ready() const { return false; }
+        DeviceStateChange await_resume() const { return change; }
+
+        bool OnDeviceChange(const DeviceStateChange& dsc) override
+        {
+            if (dsc.state != state)
+                return false;
+            change = dsc;
+            return true;
+        }
+
+    private:
+        DeviceStateChange::State state;
+        DeviceStateChange change;
+    };
+
+    inline DeviceChangeAwaiter Enumerator::DeviceAdded(CoroutineExecutor *executor)
+    {
+        return DeviceChangeAwaiter(*this, DeviceStateChange::State::ADDED, executor);
+    }
+
+    inline InputChangeAwaiter JoystickService::NextChange(int joystickID, CoroutineExecutor *executor)
+    {
+        return InputChangeAwaiter(enumerator, IsValidJoystickID(joystickID) ? joystickID : -1, executor);
+    }
+
+    template <typename Profile>
+    template <typename Button>
+    ButtonPressAwaiter JoystickServiceT<Profile>::ButtonPressed(int joystickID, Button button,
+        CoroutineExecutor *executor)
+    {
+        int index = static_cast<int>(button);
+        bool valid = index >= 0 && index < Buttons::COUNT && this->IsValidJoystickID(joystickID);
+        return ButtonPressAwaiter(this->enumerator, valid ? joystickID : -1, valid ? Buttons::Code(index) : 0, executor);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace JoystickLibrary
+{
+    /**
+    * One published version of a service's connected joystick IDs.
+    * Never modified once published, so it can be read from any thread.
+    */
+    struct JoystickIdSnapshot
+    {
+        uint64_t version;       /**< Increases with every change to the set. */
+        std::vector<int> ids;   /**< In connection order. */
+    };
+
+    /**
+    * The set of joystick IDs a service has connected. Membership is a bit
+    * per ID read with one atomic load, so validity checks take constant time
+    * and no lock. The ID list is published RCU-style as immutable snapshots:
+    * the hotplug thread builds the next version and swaps it in, and readers
+    * keep whichever version they loaded for as long as they hold it.
+    *
+    * IDs past CAPACITY fall back to a search of the current snapshot.
+    */
+    class JoystickIdSet
+    {
+    public:
+        static const int CAPACITY = 1024;
+
+        JoystickIdSet()
+        {
+            for (auto& word : bits)
+                word.store(0, std::memory_order_relaxed);
+            snapshot = std::make_shared<const JoystickIdSnapshot>(JoystickIdSnapshot { 0, std::vector<int>() });
+        }
+
+        JoystickIdSet(JoystickIdSet const&) = delete;
+        void operator=(JoystickIdSet const&) = delete;
+
+        bool Contains(int id) const
+        {
+            if (id < 0)
+                return false;
+            if (id >= CAPACITY)
+            {
+                std::shared_ptr<const JoystickIdSnapshot> current = this->Load();
+                return std::find(current->ids.begin(), current->ids.end(), id) != current->ids.end();
+            }
+            return (bits[id / 64].load(std::memory_order_acquire) >> (id % 64)) & 1;
+        }
+
+        /**
+        * Gets the current snapshot; it stays valid and unchanged while held.
+        */
+        std::shared_ptr<const JoystickIdSnapshot> Load() const
+        {
+            return std::atomic_load(&snapshot);
+        }
+
+        /**
+        * Adds an ID and publishes a new snapshot.
+        * @return false if the ID was already in the set.
+        */
+        bool Add(int id)
+        {
+            std::lock_guard<std::mutex> guard(writeLock);
+            std::shared_ptr<const JoystickIdSnapshot> current = std::atomic_load(&snapshot);
+            if (id < 0 || std::find(current->ids.begin(), current->ids.end(), id) != current->ids.end())
+                return false;
+
+            std::shared_ptr<JoystickIdSnapshot> next = std::make_shared<JoystickIdSnapshot>(*current);
+            next->version++;
+            next->ids.push_back(id);
+            std::atomic_store(&snapshot, std::shared_ptr<const JoystickIdSnapshot>(next));
+
+            // set after the snapshot, so an ID that reads valid is also listed
+            if (id < CAPACITY)
+                bits[id / 64].fetch_or(uint64_t(1) << (id % 64), std::memory_order_release);
+            return true;
+        }
+
+        /**
+        * Removes an ID and publishes a new snapshot.
+        * @return false if the ID was not in the set.
+        */
+        bool Remove(int id)
+        {
+            std::lock_guard<std::mutex> guard(writeLock);
+            std::shared_ptr<const JoystickIdSnapshot> current = std::atomic_load(&snapshot);
+            auto it = std::find(current->ids.begin(), current->ids.end(), id);
+            if (it == current->ids.end())
+                return false;
+
+            // cleared first, so an ID that reads valid is still listed
+            if (id < CAPACITY)
+                bits[id / 64].fetch_and(~(uint64_t(1) << (id % 64)), std::memory_order_release);
+
+            std::shared_ptr<JoystickIdSnapshot> next = std::make_shared<JoystickIdSnapshot>(*current);
+            next->version++;
+            next->ids.erase(next->ids.begin() + (it - current->ids.begin()));
+            std::atomic_store(&snapshot, std::shared_ptr<const JoystickIdSnapshot>(next));
+            return true;
+        }
+
+    private:
+        std::atomic<uint64_t> bits[CAPACITY / 64];
+        // copy-on-write; replaced under writeLock, read with atomic_load
+        std::shared_ptr<const JoystickIdSnapshot> snapshot;
+        std::mutex writeLock;
+    };
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Enumerator.hpp"
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace JoystickLibrary
+{
+    /**
+    * What a JoystickSampler samples and how often.
+    */
+    struct SamplerOptions
+    {
+        SamplerOptions()
+            : rateHz(100)
+        {
+        }
+
+        int rateHz;                     /**< Samples per second, e.g. 50, 100 or 250.                */
+        std::vector<int> joystickIDs;   /**< The joysticks to sample; empty for every connected one. */
+    };
+
+    /**
+    * One sample, passed to the callback on the sampler thread. The
+    * snapshots are only valid during the call.
+    */
+    struct SampleFrame
+    {
+        uint64_t tick;                      /**< Periods since Start, counting missed ones.              */
+        uint64_t deadline;                  /**< When the tick was due, CLOCK_MONOTONIC in ns.           */
+        uint64_t captureTime;               /**< When the snapshots were taken, CLOCK_MONOTONIC in ns.   */
+        uint64_t missed;                    /**< Deadlines skipped since the previous sample.            */
+        const DeviceSnapshot *snapshots;    /**< One frame; see Enumerator::GetAllSnapshots.             */
+        int count;                          /**< Entries in snapshots; selected IDs that are connected.  */
+        bool coherent;                      /**< false if the devices may be from different reader batches. */
+    };
+
+    typedef std::function<void(const SampleFrame&)> SampleCallback;
+
+    struct SamplerStats
+    {
+        uint64_t samples;           /**< Callbacks made.                                                */
+        uint64_t missed;            /**< Deadlines skipped because a sample or callback ran too long.  */
+        uint64_t torn;              /**< Samples whose frame was not coherent.                          */
+        LatencyStats lateness;      /**< Deadline to capture of each sample.                            */
+        LatencyStats periodJitter;  /**< Distance of each period between captures from the nominal one. */
+    };
+
+    /**
+    * Samples joysticks at a fixed rate on its own thread and hands each
+    * sample to a callback. The thread sleeps on a timerfd armed with
+    * absolute deadlines, so a late wakeup or a slow callback never shifts
+    * later samples; deadlines that pass while a callback runs are counted
+    * as missed and skipped rather than delivered in a burst.
+    *
+    * Devices come from Enumerator::GetInstance(), so a service must be
+    * initialized for any to be connected.
+    */
+    class JoystickSampler
+    {
+    public:
+        JoystickSampler();
+        ~JoystickSampler();
+        JoystickSampler(JoystickSampler const&) = delete;
+        void operator=(JoystickSampler const&) = delete;
+
+        /**
+        * Starts sampling; the first sample is due one period from now.
+        * @param options the rate and the joysticks to sample
+        * @param callback called on the sampler thread for every sample; must not call Stop
+        * @return false if already running, rateHz or a joystick ID is out of range, or the timer cannot be
+        * created; true otherwise.
+        */
+        bool Start(const SamplerOptions& options, SampleCallback callback);
+
+        /**
+        * Stops sampling and waits for a running callback to return.
+        */
+        void Stop();
+
+        bool IsRunning() const;
+
+        /**
+        * Gets the sample count, missed deadlines and p50/p99/max lateness and jitter.
+        */
+        SamplerStats GetStats() const;
+
+        /**
+        * Gets the full period jitter histogram, e.g. for other percentiles.
+        */
+        const LatencyHistogram& GetPeriodJitter() const { return periodJitter; }
+
+        /**
+        * Gets the full deadline-to-capture histogram.
+        */
+        const LatencyHistogram& GetLateness() const { return lateness; }
+
+        /**
+        * Clears the counters and histograms.
+        */
+        void ResetStats();
+
+    private:
+        void Run();
+        int Select(DeviceSnapshot *snapshots, int count) const;
+
+        SamplerOptions options;
+        SampleCallback callback;
+        uint64_t period;
+        uint64_t firstDeadline;
+        // one entry per possible ID; sized by Start
+        std::vector<DeviceSnapshot> frame;
+        std::vector<bool> selected;
+        int timer_fd;
+        int stop_fd;
+        std::thread thread;
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> missed;
+        std::atomic<uint64_t> torn;
+        LatencyHistogram lateness;
+        LatencyHistogram periodJitter;
+    };
+}
@@ -1,10 +1,16 @@
 #pragma once
 
 #include "Enumerator.hpp"
+#include "JoystickIdSet.hpp"
 #include <array>
 
 namespace JoystickLibrary
 {
+#if !defined(_WIN32) && defined(__cpp_impl_coroutine)
+    // see JoystickCoroutines.hpp
+    class InputChangeAwaiter;
+#endif
+
     class JoystickService
     {
     public:
@@ -12,7 +18,93 @@ namespace JoystickLibrary
         virtual ~JoystickService();
         bool Initialize();
         int GetNumberConnected() const;
-        const std::vector<int>& GetIDs() const;
+
+        /**
+        * Gets a copy of the connected joystick IDs, in connection order.
+        */
+        std::vector<int> GetIDs() const;
+
+        /**
+        * Gets the current version of the connected joystick IDs without copying
+        * them. The snapshot never changes; load it again to see later changes.
+        */
+        std::shared_ptr<const JoystickIdSnapshot> GetIDSnapshot() const;
+
+#ifndef _WIN32
+        /**
+        * Subscribes to input changes from one of this service's joysticks.
+        * @param joystickID the joystick ID
+        * @param options event types, queue size and overflow policy; options.joystickID is ignored.
+        * @return the subscription, or nullptr if joystickID is invalid.
+        */
+        std::shared_ptr<InputSubscription> Subscribe(int joystickID, SubscriptionOptions options = SubscriptionOptions());
+
+        /**
+        * Stops delivery to a subscription returned by Subscribe.
+        */
+        void Unsubscribe(const std::shared_ptr<InputSubscription>& subscription);
+
+        /**
+        * Gets the raw timestamped event ring of one of this service's joysticks.
+        * @param joystickID the joystick ID
+        * @return the ring, or nullptr if joystickID is invalid.
+        */
+        const EventRing *GetEventRing(int joystickID) const;
+
+        /**
+        * Gets p50/p99/max input latency of one of this service's joysticks.
+        * QUERY samples are only taken while Enumerator::SetLatencyTracking is on.
+        * @param joystickID the joystick ID
+        * @param kind APPLY for event-to-publish, QUERY for event-to-getter
+        * @param stats A reference in which to save the summary. Will not be modified if call fails.
+        * @return false if invalid joystickID, true otherwise.
+        */
+        bool GetLatencyStats(int joystickID, LatencyKind kind, LatencyStats& stats) const;
+
+        /**
+        * Clears the latency histograms of one of this service's joysticks.
+        * @return false if invalid joystickID, true otherwise.
+        */
+        bool ResetLatencyStats(int joystickID);
+
+        /**
+        * Shapes one axis of one of this service's joysticks; see Enumerator::SetAxisShaping.
+        * @param joystickID the joystick ID
+        * @param code the ABS_* code
+        * @param shaping deadzones, expo, smoothing and slew limit; a default AxisShaping turns shaping off
+        * @return false if invalid joystickID or code, true otherwise.
+        */
+        bool SetAxisShaping(int joystickID, int code, const AxisShaping& shaping);
+
+        /**
+        * Blocks until this service has a joystick connected. The reader
+        * thread wakes the caller when one connects; nothing polls.
+        * @param timeoutMs how long to wait at most; negative waits until one connects
+        * @return false if the wait timed out, true otherwise.
+        */
+        bool WaitForDevice(int timeoutMs = -1);
+
+        /**
+        * Blocks until an axis or button of one of this service's joysticks
+        * changes from the values it has when the call starts. The reader
+        * thread wakes the caller when it publishes the change.
+        * @param joystickID the joystick ID
+        * @param timeoutMs how long to wait at most; negative waits until a change
+        * @return false if invalid joystickID, the joystick disconnected or the wait timed out, true otherwise.
+        */
+        bool WaitForChange(int joystickID, int timeoutMs = -1);
+
+#ifdef __cpp_impl_coroutine
+        /**
+        * Awaits the next change to an axis or button of one of this service's
+        * joysticks; see JoystickCoroutines.hpp.
+        * @param joystickID the joystick ID
+        * @param executor where to resume the coroutine; nullptr resumes it on the reader thread.
+        * @return an awaiter resuming with false if joystickID is invalid or the joystick disconnects first.
+        */
+        InputChangeAwaiter NextChange(int joystickID, CoroutineExecutor *executor = nullptr);
+#endif
+#endif
 
     protected:
 #ifdef _WIN32
@@ -28,15 +120,31 @@ namespace JoystickLibrary
         };
 #else
         int GetAxis(int id, int axisId) const;
+
+        /**
+        * Lists the devices this service handles, so Initialize can have the
+        * enumerator route only their changes to OnDeviceChanged.
+        * @param descriptors A reference in which to append the descriptors.
+        * @return false to receive every device change instead, true otherwise.
+        */
+        virtual bool GetDescriptors(std::vector<JoystickDescriptor>& descriptors) const;
+
+        /**
+        * Routes more devices to OnDeviceChanged after Initialize; devices
+        * already connected are announced right away.
+        */
+        void RouteDescriptors(const std::vector<JoystickDescriptor>& descriptors);
 #endif
 
         virtual void OnDeviceChanged(DeviceStateChange ds) = 0;
         void ProcessDeviceChange(std::vector<JoystickDescriptor> id_list, DeviceStateChange dsc);
+        void TrackDevice(DeviceStateChange dsc);
         bool IsValidJoystickID(int id) const;
         JoystickState GetState(int id) const;
 
         Enumerator& enumerator = Enumerator::GetInstance();
-        std::vector<int> ids;
+        // written by the hotplug thread, read from any thread
+        JoystickIdSet ids;
         bool initialized;
         
     };
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "AxisScale.hpp"
+#include "JoystickService.hpp"
+
+#ifndef _WIN32
+namespace JoystickLibrary
+{
+#ifdef __cpp_impl_coroutine
+    // see JoystickCoroutines.hpp
+    class ButtonPressAwaiter;
+#endif
+
+    /**
+    * One supported vendor/product pair of a device profile.
+    */
+    template <int VendorID, int ProductID>
+    struct Descriptor
+    {
+        static constexpr bool Matches(int vendorID, int productID)
+        {
+            return vendorID == VendorID && productID == ProductID;
+        }
+
+        static JoystickDescriptor Get()
+        {
+            return { VendorID, ProductID };
+        }
+    };
+
+    /**
+    * Every vendor/product pair a profile accepts; matching unrolls at compile time.
+    */
+    template <typename... Descriptors>
+    struct DescriptorList;
+
+    template <>
+    struct DescriptorList<>
+    {
+        static const int COUNT = 0;
+
+        static constexpr bool Matches(int, int)
+        {
+            return false;
+        }
+
+        static void Append(std::vector<JoystickDescriptor>&)
+        {
+        }
+    };
+
+    template <typename First, typename... Rest>
+    struct DescriptorList<First, Rest...>
+    {
+        static const int COUNT = 1 + sizeof...(Rest);
+
+        static constexpr bool Matches(int vendorID, int productID)
+        {
+            return First::Matches(vendorID, productID) || DescriptorList<Rest...>::Matches(vendorID, productID);
+        }
+
+        static void Append(std::vector<JoystickDescriptor>& descriptors)
+        {
+            descriptors.push_back(First::Get());
+            DescriptorList<Rest...>::Append(descriptors);
+        }
+    };
+
+    /**
+    * An axis scaled to -100..100, Min reading -100 and Max reading +100.
+    * Sign -1 flips the axis, e.g. so pushing a stick forwards reads positive.
+    */
+    template <int Code, int Min, int Max, int Sign = 1>
+    struct CenteredAxis
+    {
+        static_assert(Min != Max, "axis range must not be empty");
+        static_assert(Code >= 0 && Code < ABS_CNT, "axis code out of range");
+
+        typedef AxisMap<Min, Max, -100 * Sign, 100 * Sign> Map;
+        static const int CODE = Code;
+        static const int RAW_MIN = Min;
+        static const int RAW_MAX = Max;
+
+        static int Read(const JoystickState& state)
+        {
+            return Map::Apply(state.GetAxis(Code));
+        }
+
+        static constexpr int Normalize(int raw)
+        {
+            return Map::Apply(raw);
+        }
+
+        /**
+        * Checks every step-th raw value against exact division; for static_asserts.
+        */
+        static constexpr bool IsExact(int step)
+        {
+            return IsExactMap<Map>(Min < Max ? Min : Max, Min < Max ? Max : Min, step);
+        }
+    };
+
+    /**
+    * An axis scaled to 0..100, Min reading 0 and Max reading 100. Min may be
+    * the larger end, like the Extreme 3D Pro throttle (Min 255, Max 0).
+    */
+    template <int Code, int Min, int Max>
+    struct PercentAxis
+    {
+        static_assert(Min != Max, "axis range must not be empty");
+        static_assert(Code >= 0 && Code < ABS_CNT, "axis code out of range");
+
+        typedef AxisMap<Min, Max, 0, 100> Map;
+        static const int CODE = Code;
+        static const int RAW_MIN = Min;
+        static const int RAW_MAX = Max;
+
+        static int Read(const JoystickState& state)
+        {
+            return Map::Apply(state.GetAxis(Code));
+        }
+
+        static constexpr int Normalize(int raw)
+        {
+            return Map::Apply(raw);
+        }
+
+        static constexpr bool IsExact(int step)
+        {
+            return IsExactMap<Map>(Min < Max ? Min : Max, Min < Max ? Max : Min, step);
+        }
+    };
+
+    /**
+    * A hat reported as an ABS_HAT*X/ABS_HAT*Y pair.
+    */
+    template <int CodeX>
+    struct HatAxis
+    {
+        static_assert(CodeX >= ABS_HAT0X && CodeX <= ABS_HAT3X && (CodeX - ABS_HAT0X) % 2 == 0,
+            "hat must start at an ABS_HAT*X code");
+
+        static POV Read(const JoystickState& state)
+        {
+            return HatToPOV(state.GetAxis(CodeX), state.GetAxis(CodeX + 1));
+        }
+    };
+
+    /**
+    * Buttons numbered from 0 at consecutive BTN_* codes starting at Base.
+    */
+    template <int Base, int Count>
+    struct ButtonRange
+    {
+        static_assert(Count > 0 && Count <= 32, "button count must fit a 32-bit mask");
+        static_assert(Base >= 0 && Base + Count <= KEY_CNT, "button codes out of range");
+
+        static const int COUNT = Count;
+
+        static constexpr int Code(int index)
+        {
+            return Base + index;
+        }
+    };
+
+    /**
+    * Buttons numbered from 0 at arbitrary BTN_* codes.
+    */
+    template <int... Codes>
+    struct ButtonList
+    {
+        static_assert(sizeof...(Codes) > 0 && sizeof...(Codes) <= 32, "button count must fit a 32-bit mask");
+
+        static const int COUNT = sizeof...(Codes);
+
+        static int Code(int index)
+        {
+            static const int codes[] = { Codes... };
+            return codes[index];
+        }
+    };
+
+    /**
+    * A service whose device support is described entirely by a profile type:
+    *
+    *   struct Profile
+    *   {
+    *       typedef DescriptorList<Descriptor<vid, pid>, ...> Descriptors;
+    *       typedef ButtonRange<BTN_TRIGGER, 12> Buttons;    // or ButtonList<...>
+    *       // plus any CenteredAxis, PercentAxis and HatAxis typedefs it reads
+    *   };
+    *
+    * Descriptor matching, axis scaling constants and button codes resolve at
+    * compile time, and the read path has no virtual calls. Only devices in
+    * Descriptors are routed to the service.
+    */
+    template <typename Profile>
+    class JoystickServiceT : public JoystickService
+    {
+    public:
+        typedef typename Profile::Descriptors Descriptors;
+        typedef typename Profile::Buttons Buttons;
+
+        static bool Matches(const JoystickDescriptor& descriptor)
+        {
+            return Descriptors::Matches(descriptor.vendor_id, descriptor.product_id);
+        }
+
+        /**
+        * Reads one of the profile's axes.
+        * @param joystickID the joystick ID
+        * @param value A reference in which to save the value. Will not be modified if call fails.
+        * @return false if invalid joystickID or disconnected joystick, true otherwise.
+        */
+        template <typename Axis>
+        bool ReadAxis(int joystickID, int& value) const
+        {
+            if (!IsValidJoystickID(joystickID))
+                return false;
+
+            value = Axis::Read(this->GetState(joystickID));
+            return true;
+        }
+
+        /**
+        * Shapes one of the profile's axes; see Enumerator::SetAxisShaping.
+        * The axis's range is filled in unless shaping gives one.
+        * @param joystickID the joystick ID
+        * @param shaping deadzones, expo, smoothing and slew limit; a default AxisShaping turns shaping off
+        * @return false if invalid joystickID, true otherwise.
+        */
+        template <typename Axis>
+        bool SetShaping(int joystickID, AxisShaping shaping)
+        {
+            if (shaping.rangeMinimum == shaping.rangeMaximum)
+            {
+                shaping.rangeMinimum = Axis::RAW_MIN;
+                shaping.rangeMaximum = Axis::RAW_MAX;
+            }
+            return this->SetAxisShaping(joystickID, Axis::CODE, shaping);
+        }
+
+        /**
+        * Reads one of the profile's hats.
+        * @param joystickID the joystick ID
+        * @param pov A reference in which to save the value. Will not be modified if call fails.
+        * @return false if invalid joystickID or disconnected joystick, true otherwise.
+        */
+        template <typename Hat>
+        bool ReadHat(int joystickID, POV& pov) const
+        {
+            if (!IsValidJoystickID(joystickID))
+                return false;
+
+            pov = Hat::Read(this->GetState(joystickID));
+            return true;
+        }
+
+        /**
+        * Reads one of the profile's buttons.
+        * @param joystickID the joystick ID
+        * @param index the button's position in the profile, from 0
+        * @param pressed A reference in which to save the value. Will not be modified if call fails.
+        * @return false if invalid joystickID, disconnected joystick or index, true otherwise.
+        */
+        bool ReadButton(int joystickID, int index, bool& pressed) const
+        {
+            if (index < 0 || index >= Buttons::COUNT || !IsValidJoystickID(joystickID))
+                return false;
+
+            pressed = this->GetState(joystickID).GetButton(Buttons::Code(index));
+            return true;
+        }
+
+#ifdef __cpp_impl_coroutine
+        /**
+        * Awaits one of the profile's buttons being pressed; see JoystickCoroutines.hpp.
+        * @param joystickID the joystick ID
+        * @param button the button's position in the profile, e.g. Extreme3DProButton::Trigger
+        * @param executor where to resume the coroutine; nullptr resumes it on the reader thread.
+        * @return an awaiter resuming with false if joystickID or button is invalid or the joystick
+        * disconnects first.
+        */
+        template <typename Button>
+        ButtonPressAwaiter ButtonPressed(int joystickID, Button button, CoroutineExecutor *executor = nullptr);
+#endif
+
+        /**
+        * Packs every profile button of a state into a mask, bit n for button n.
+        */
+        static uint32_t ButtonMask(const JoystickState& state)
+        {
+            uint32_t mask = 0;
+            for (int i = 0; i < Buttons::COUNT; i++)
+            {
+                if (state.GetButton(Buttons::Code(i)))
+                    mask |= 1u << i;
+            }
+            return mask;
+        }
+
+    protected:
+        bool GetDescriptors(std::vector<JoystickDescriptor>& descriptors) const override
+        {
+            Descriptors::Append(descriptors);
+            return true;
+        }
+
+        void OnDeviceChanged(DeviceStateChange ds)
+        {
+            if (Matches(ds.descriptor))
+                this->TrackDevice(ds);
+        }
+    };
+}
+#endif
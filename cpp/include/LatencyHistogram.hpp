@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace JoystickLibrary
+{
+    enum class LatencyKind
+    {
+        APPLY,      /**< Kernel event timestamp to the reader thread publishing the state. */
+        QUERY       /**< Kernel event timestamp to a getter returning the state.           */
+    };
+
+    struct LatencyStats
+    {
+        uint64_t count;     /**< Number of samples recorded.         */
+        uint64_t p50;       /**< Median, in ns.                      */
+        uint64_t p99;       /**< 99th percentile, in ns.             */
+        uint64_t max;       /**< Largest sample, in ns.              */
+    };
+
+    /**
+    * Log-linear histogram of nanosecond durations.
+    * Values below 2^SUB_BITS land in exact buckets; above that every power of
+    * two is split into 2^SUB_BITS buckets, so a reported percentile is at most
+    * 1/2^SUB_BITS above the true value. Recording is a relaxed atomic
+    * increment, so any number of threads can record concurrently.
+    */
+    class LatencyHistogram
+    {
+    public:
+        static const int SUB_BITS = 4;
+        static const int SUB_COUNT = 1 << SUB_BITS;
+        static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+        LatencyHistogram()
+        {
+            Reset();
+        }
+
+        LatencyHistogram(LatencyHistogram const&) = delete;
+        void operator=(LatencyHistogram const&) = delete;
+
+        void Record(uint64_t ns)
+        {
+            buckets[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t seen = largest.load(std::memory_order_relaxed);
+            while (ns > seen && !largest.compare_exchange_weak(seen, ns, std::memory_order_relaxed))
+                ;
+        }
+
+        /**
+        * Clears all samples. Samples recorded concurrently may or may not survive.
+        */
+        void Reset()
+        {
+            for (auto& bucket : buckets)
+                bucket.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+            largest.store(0, std::memory_order_relaxed);
+        }
+
+        uint64_t GetCount() const
+        {
+            return total.load(std::memory_order_relaxed);
+        }
+
+        uint64_t GetMax() const
+        {
+            return largest.load(std::memory_order_relaxed);
+        }
+
+        /**
+        * Gets the value at or below which the given fraction of samples fall.
+        * @param fraction the quantile, between 0 and 1
+        * @return the upper edge of the bucket holding that quantile, in ns; 0 if empty.
+        */
+        uint64_t GetPercentile(double fraction) const
+        {
+            uint64_t count = 0;
+            uint64_t counts[BUCKETS];
+            for (int i = 0; i < BUCKETS; i++)
+            {
+                counts[i] = buckets[i].load(std::memory_order_relaxed);
+                count += counts[i];
+            }
+            if (count == 0)
+                return 0;
+
+            uint64_t rank = static_cast<uint64_t>(fraction * count);
+            if (rank >= count)
+                rank = count - 1;
+
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; i++)
+            {
+                seen += counts[i];
+                if (seen > rank)
+                {
+                    uint64_t edge = BucketUpperEdge(i);
+                    uint64_t max = GetMax();
+                    return edge < max ? edge : max;
+                }
+            }
+            return GetMax();
+        }
+
+        LatencyStats GetStats() const
+        {
+            LatencyStats stats;
+            stats.count = GetCount();
+            stats.p50 = GetPercentile(0.50);
+            stats.p99 = GetPercentile(0.99);
+            stats.max = GetMax();
+            return stats;
+        }
+
+        static int BucketIndex(uint64_t ns)
+        {
+            if (ns < SUB_COUNT)
+                return static_cast<int>(ns);
+
+            int exponent = 63 - __builtin_clzll(ns);
+            int sub = static_cast<int>((ns >> (exponent - SUB_BITS)) & (SUB_COUNT - 1));
+            return (exponent - SUB_BITS + 1) * SUB_COUNT + sub;
+        }
+
+        static uint64_t BucketUpperEdge(int index)
+        {
+            if (index < SUB_COUNT)
+                return static_cast<uint64_t>(index);
+
+            int exponent = index / SUB_COUNT + SUB_BITS - 1;
+            uint64_t sub = static_cast<uint64_t>(index % SUB_COUNT);
+            uint64_t width = uint64_t(1) << (exponent - SUB_BITS);
+            return ((SUB_COUNT + sub) << (exponent - SUB_BITS)) + (width - 1);
+        }
+
+    private:
+        std::atomic<uint64_t> buckets[BUCKETS];
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> largest;
+    };
+}
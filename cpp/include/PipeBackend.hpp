@@ -0,0 +1,67 @@
+#pragma once
+
+#include "InputBackend.hpp"
+#include <atomic>
+#include <map>
+
+namespace JoystickLibrary
+{
+    /**
+    * Backend whose devices read raw struct input_event records from pipes,
+    * FIFOs or sockets, so another thread or process can feed recorded or
+    * generated streams through the same read path as hardware.
+    *
+    * The stream follows kernel evdev framing. A SYN_DROPPED record starts a
+    * resync: the records after it up to the next SYN_REPORT are delivered as
+    * the sync delta, so the writer should send the full current state there.
+    * End of stream or a read error disconnects the device.
+    */
+    class PipeBackend : public InputBackend
+    {
+    public:
+        PipeBackend();
+        ~PipeBackend();
+        PipeBackend(PipeBackend const&) = delete;
+        void operator=(PipeBackend const&) = delete;
+
+        /**
+        * Plugs in a device fed from fd.
+        * @param path the device path; reusing the path and descriptor of a detached device reconnects its ID.
+        * @param descriptor the vendor and product IDs
+        * @param fd the read end of the stream; the backend takes ownership and makes it non-blocking.
+        * @param initial the axes and buttons the device has and their starting values
+        * @return false if path is already attached, true otherwise.
+        */
+        bool Attach(const std::string& path, JoystickDescriptor descriptor, int fd,
+            const JoystickState& initial = JoystickState());
+
+        /**
+        * Unplugs a device. Its reads fail from then on.
+        * @return false if path is not attached, true otherwise.
+        */
+        bool Detach(const std::string& path);
+
+        bool Start() override;
+        int GetFd() const override;
+        void Scan(std::vector<std::string>& paths) override;
+        void Receive(std::vector<HotplugEvent>& events) override;
+        std::unique_ptr<InputDevice> Open(const char *path) override;
+
+    private:
+        struct Stream
+        {
+            ~Stream();
+
+            JoystickDescriptor descriptor;
+            JoystickState initial;
+            int fd;
+            std::atomic<bool> detached;
+        };
+
+        friend class PipeInputDevice;
+
+        std::mutex lock;
+        std::map<std::string, std::shared_ptr<Stream>> attached;
+        HotplugQueue hotplug;
+    };
+}
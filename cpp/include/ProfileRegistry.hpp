@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Types.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+namespace JoystickLibrary
+{
+    enum class ControllerAxis : int
+    {
+        LeftX = 0,
+        LeftY,
+        RightX,
+        RightY,
+        LeftTrigger,
+        RightTrigger
+    };
+
+    enum class ControllerButton : int
+    {
+        A = 0,
+        B,
+        X,
+        Y,
+        Back,
+        Guide,
+        Start,
+        LeftStick,
+        RightStick,
+        LeftShoulder,
+        RightShoulder,
+        DpadUp,
+        DpadDown,
+        DpadLeft,
+        DpadRight
+    };
+
+    constexpr int CONTROLLER_AXIS_COUNT = static_cast<int>(ControllerAxis::RightTrigger) + 1;
+    constexpr int CONTROLLER_BUTTON_COUNT = static_cast<int>(ControllerButton::DpadRight) + 1;
+
+    /**
+    * One input a controller element is mapped from, as written in a mapping
+    * string: "b3" (button 3), "a1" (axis 1), "+a1"/"-a1" (one half of axis 1),
+    * "a1~" (axis 1 inverted) or "h0.4" (hat 0 pointing down).
+    */
+    struct MappingSource
+    {
+        enum class Kind : uint8_t
+        {
+            NONE, BUTTON, AXIS, HAT
+        };
+
+        Kind kind;
+        uint8_t index;      /**< Button, axis or hat number in the device's own order.  */
+        int8_t half;        /**< -1 or +1 for a half axis, 0 for the whole axis.        */
+        bool invert;
+        uint8_t hatMask;    /**< 1 up, 2 right, 4 down, 8 left.                         */
+    };
+
+    /**
+    * A controller layout parsed from one mapping string.
+    */
+    struct ControllerProfile
+    {
+        JoystickDescriptor descriptor;
+        std::string name;
+        MappingSource axes[CONTROLLER_AXIS_COUNT];
+        MappingSource buttons[CONTROLLER_BUTTON_COUNT];
+    };
+
+    /**
+    * Controller layouts keyed by vendor/product, loaded from SDL
+    * gamecontrollerdb-style mapping strings:
+    *
+    *   030000005e0400008e02000014010000,Xbox 360 Controller,a:b0,b:b1,...,leftx:a0,lefty:a1,platform:Linux,
+    *
+    * Vendor and product come from the GUID. Mappings for other platforms,
+    * name-based GUIDs and elements without a counterpart here (paddles,
+    * touchpads, half-axis outputs) are skipped.
+    */
+    class ProfileRegistry
+    {
+    public:
+        ProfileRegistry();
+        ProfileRegistry(ProfileRegistry const&) = delete;
+        void operator=(ProfileRegistry const&) = delete;
+
+        /**
+        * Parses one mapping string, replacing any profile with the same descriptor.
+        * @param mapping the mapping string
+        * @param added A reference to which to append the descriptor if it was not registered before.
+        * @return false if the mapping is malformed, for another platform or has no vendor/product, true otherwise.
+        */
+        bool AddMapping(const std::string& mapping, std::vector<JoystickDescriptor>& added);
+
+        /**
+        * Parses mapping strings one per line; empty lines and '#' comments are skipped.
+        * @param mappings the mapping strings
+        * @param added A reference to which to append the descriptors not registered before.
+        * @return the number of mappings loaded.
+        */
+        int AddMappings(const std::string& mappings, std::vector<JoystickDescriptor>& added);
+
+        /**
+        * Reads mapping strings from a file such as gamecontrollerdb.txt.
+        * @return the number of mappings loaded, or -1 if the file cannot be read.
+        */
+        int AddMappingsFromFile(const char *path, std::vector<JoystickDescriptor>& added);
+
+        /**
+        * Looks up the profile of a device.
+        * @return the profile, or nullptr if none is registered.
+        */
+        std::shared_ptr<const ControllerProfile> Find(const JoystickDescriptor& descriptor) const;
+
+        int GetCount() const;
+        void GetDescriptors(std::vector<JoystickDescriptor>& descriptors) const;
+
+    private:
+        static bool Parse(const std::string& mapping, ControllerProfile& profile);
+
+        mutable std::mutex lock;
+        // profiles are immutable once published; a reload swaps the pointer
+        std::unordered_map<uint32_t, std::shared_ptr<const ControllerProfile>> profiles;
+    };
+}
+#endif
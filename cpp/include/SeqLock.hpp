@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace JoystickLibrary
+{
+    /**
+    * Single-writer sequence lock around a trivially copyable value.
+    * The writer never waits on readers, and any number of readers copy out
+    * a consistent version without taking a lock, retrying only if a store
+    * overlapped their copy. The value is kept as relaxed atomic words so the
+    * concurrent copy is well defined.
+    */
+    template <typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "SeqLock values must be trivially copyable");
+
+    public:
+        SeqLock()
+        {
+            sequence.store(0, std::memory_order_relaxed);
+            for (auto& word : words)
+                word.store(0, std::memory_order_relaxed);
+        }
+
+        SeqLock(SeqLock const&) = delete;
+        void operator=(SeqLock const&) = delete;
+
+        /**
+        * Publishes a new value. Must only be called from one thread at a time.
+        * @param value the value to publish
+        */
+        void Store(const T& value)
+        {
+            uint64_t buffer[WORDS] = { };
+            memcpy(buffer, &value, sizeof(T));
+
+            uint64_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < WORDS; i++)
+                words[i].store(buffer[i], std::memory_order_relaxed);
+
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+        * Copies out the most recently published value.
+        * @param value A reference in which to save the value.
+        * @return the version that was read; even, and increasing with every store.
+        */
+        uint64_t Load(T& value) const
+        {
+            uint64_t buffer[WORDS];
+            uint64_t before, after;
+
+            do
+            {
+                before = sequence.load(std::memory_order_acquire);
+                if (before & 1)
+                {
+                    // a store is in progress; try again once it lands
+                    after = before + 1;
+                    continue;
+                }
+
+                for (size_t i = 0; i < WORDS; i++)
+                    buffer[i] = words[i].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while (before != after);
+
+            memcpy(&value, buffer, sizeof(T));
+            return before;
+        }
+
+        /**
+        * Gets the current version without copying the value.
+        * @return the current sequence number; odd while a store is in progress.
+        */
+        uint64_t GetVersion() const
+        {
+            return sequence.load(std::memory_order_acquire);
+        }
+
+    private:
+        static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> words[WORDS];
+    };
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "InputBackend.hpp"
+#include <condition_variable>
+#include <deque>
+#include <map>
+
+namespace JoystickLibrary
+{
+    /**
+    * A scripted device plugged into a SyntheticBackend. Every call may come
+    * from any thread and is delivered to the reader thread in call order.
+    */
+    class SyntheticDevice
+    {
+    public:
+        ~SyntheticDevice();
+        SyntheticDevice(SyntheticDevice const&) = delete;
+        void operator=(SyntheticDevice const&) = delete;
+
+        const std::string& GetPath() const { return path; }
+        JoystickDescriptor GetDescriptor() const { return descriptor; }
+
+        /**
+        * Queues one event.
+        * @param type EV_ABS, EV_KEY or EV_SYN
+        * @param code the ABS_*, BTN_* or SYN_* code
+        * @param value the new value
+        * @param eventTime the CLOCK_MONOTONIC event timestamp in ns; 0 stamps it now.
+        */
+        void Emit(uint16_t type, uint16_t code, int32_t value, uint64_t eventTime = 0);
+
+        /**
+        * Queues a SYN_REPORT, ending the current frame.
+        */
+        void Report(uint64_t eventTime = 0);
+
+        /**
+        * Discards every queued event as if the kernel buffer overflowed. The
+        * reader then sees SYN_DROPPED and a sync delta that brings it up to
+        * the device's state as of this call.
+        */
+        void DropEvents();
+
+        /**
+        * Makes the next read fail as if the device returned an I/O error.
+        */
+        void FailReads();
+
+        /**
+        * Gets how many events are queued and not yet read.
+        */
+        size_t GetQueued();
+
+        /**
+        * Checks whether the enumerator has let go of the device, so its path
+        * can be plugged in again without racing the old connection.
+        */
+        bool IsReleased();
+
+        /**
+        * Waits until the reader thread has read all but count queued events.
+        * @param count how many events may stay queued
+        * @param timeoutMs the longest to wait, in ms; -1 waits indefinitely
+        * @return false if the wait timed out, true otherwise.
+        */
+        bool WaitQueued(size_t count, int timeoutMs = -1);
+
+        /**
+        * Waits until IsReleased would return true.
+        * @param timeoutMs the longest to wait, in ms; -1 waits indefinitely
+        * @return false if the wait timed out, true otherwise.
+        */
+        bool WaitReleased(int timeoutMs = -1);
+
+    private:
+        friend class SyntheticBackend;
+        friend class SyntheticInputDevice;
+
+        SyntheticDevice(const std::string& path, JoystickDescriptor descriptor, const JoystickState& initial,
+            const std::string& stableKey);
+        void Wake();
+        void Progress();
+        template <typename Done>
+        bool wait_until(int timeoutMs, Done done);
+
+        std::string path;
+        JoystickDescriptor descriptor;
+        std::string stableKey;
+        std::mutex lock;
+        int event_fd;
+        std::deque<struct input_event> queue;
+        // what the device holds, and what the reader has been handed so far
+        JoystickState current;
+        JoystickState delivered;
+        // delta waiting to be read after a DropEvents
+        std::deque<struct input_event> syncDelta;
+        bool dropped;
+        bool failed;
+        bool unplugged;
+        // InputDevices currently opened on this device
+        int openCount;
+        // signalled as events are read or the device let go of, while anyone waits
+        std::condition_variable progress;
+        int waiting;
+    };
+
+    /**
+    * In-process backend whose devices and hotplug are driven by the caller, so
+    * hotplug, high-rate streams, SYN_DROPPED and read errors can be scripted
+    * deterministically without hardware. Install it with Enumerator::SetBackend
+    * before the first Start.
+    */
+    class SyntheticBackend : public InputBackend
+    {
+    public:
+        SyntheticBackend();
+        ~SyntheticBackend();
+        SyntheticBackend(SyntheticBackend const&) = delete;
+        void operator=(SyntheticBackend const&) = delete;
+
+        /**
+        * Plugs in a device.
+        * @param path the device path
+        * @param descriptor the vendor and product IDs
+        * @param initial the axes and buttons the device has and their starting values
+        * @param stableKey a serial number or port; plugging a device with the descriptor and key of an unplugged
+        * one reconnects its ID under any path. Empty for none, so only the same path and descriptor reconnect.
+        * @return the device to script, or nullptr if path is already plugged in.
+        */
+        std::shared_ptr<SyntheticDevice> Plug(const std::string& path, JoystickDescriptor descriptor,
+            const JoystickState& initial, const std::string& stableKey = std::string());
+
+        /**
+        * Unplugs a device. Its reads fail from then on, like a yanked USB device.
+        * @return false if path is not plugged in, true otherwise.
+        */
+        bool Unplug(const std::string& path);
+
+        bool Start() override;
+        int GetFd() const override;
+        void Scan(std::vector<std::string>& paths) override;
+        void Receive(std::vector<HotplugEvent>& events) override;
+        std::unique_ptr<InputDevice> Open(const char *path) override;
+
+    private:
+        std::mutex lock;
+        std::map<std::string, std::shared_ptr<SyntheticDevice>> plugged;
+        HotplugQueue hotplug;
+    };
+}
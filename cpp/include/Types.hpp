@@ -5,6 +5,9 @@
 #include <cstring>
 #include <string>
 #include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include "SeqLock.hpp"
 
 #ifdef _WIN32
     #define DIRECTINPUT_VERSION 0x0800
@@ -30,20 +33,88 @@
     #include <libudev.h>
     #include <stdlib.h>
     #include <locale.h>
+    #include <time.h>
+    #include <sys/time.h>
     #include <thread>
     #include <mutex>
+    #include <atomic>
+    #include <memory>
+    #include "EventRing.hpp"
+    #include "InputShaping.hpp"
+    #include "LatencyHistogram.hpp"
+
+    namespace JoystickLibrary
+    {
+        class InputDevice;
+    }
 
     typedef struct JoystickHandle
     {
-        struct libevdev *dev;
-        int fd;
+        JoystickLibrary::InputDevice *device; // nullptr while disconnected
         char path[64]; // "/dev/input/event*"
     } JoystickHandle;
 
+    // flat, trivially copyable snapshot of a device: one slot per ABS_* code
+    // and one bit per KEY_*/BTN_* code, plus the codes the device reports
     struct JoystickState
     {
-        std::map<int, int> axes;
-        std::map<int, bool> buttons;
+        int axes[ABS_CNT];
+        uint64_t axisCaps;
+        uint64_t buttons[(KEY_CNT + 63) / 64];
+        uint64_t buttonCaps[(KEY_CNT + 63) / 64];
+        uint64_t eventTime;     // kernel timestamp of the last applied report, in ns
+
+        bool HasAxis(int code) const
+        {
+            return code >= 0 && code < ABS_CNT && ((axisCaps >> code) & 1);
+        }
+
+        int GetAxis(int code) const
+        {
+            return (code >= 0 && code < ABS_CNT) ? axes[code] : 0;
+        }
+
+        void SetAxis(int code, int value)
+        {
+            if (code < 0 || code >= ABS_CNT)
+                return;
+            axes[code] = value;
+            axisCaps |= uint64_t(1) << code;
+        }
+
+        bool HasButton(int code) const
+        {
+            return code >= 0 && code < KEY_CNT && ((buttonCaps[code / 64] >> (code % 64)) & 1);
+        }
+
+        bool GetButton(int code) const
+        {
+            return code >= 0 && code < KEY_CNT && ((buttons[code / 64] >> (code % 64)) & 1);
+        }
+
+        void SetButton(int code, bool value)
+        {
+            if (code < 0 || code >= KEY_CNT)
+                return;
+            uint64_t bit = uint64_t(1) << (code % 64);
+            buttons[code / 64] = value ? (buttons[code / 64] | bit) : (buttons[code / 64] & ~bit);
+            buttonCaps[code / 64] |= bit;
+        }
+
+        // the same axis and button values; a republished report is not a change
+        bool SameInputs(const JoystickState& other) const
+        {
+            return memcmp(axes, other.axes, sizeof(axes)) == 0 && memcmp(buttons, other.buttons, sizeof(buttons)) == 0;
+        }
+    };
+
+    static_assert(std::is_trivially_copyable<JoystickState>::value, "JoystickState must stay memcpy-able");
+
+    // reported range of one ABS_* axis; minimum == maximum when the backend does not know it
+    struct AxisRange
+    {
+        int minimum;
+        int maximum;
     };
 #endif
 
@@ -62,6 +133,18 @@ namespace JoystickLibrary
         POV_SOUTHEAST = POV_SOUTH | POV_EAST        /**< POV hat is facing south and right.  */
     };
 
+    /**
+    * Converts a pair of evdev hat axis values (-1, 0 or 1 each) to a POV direction.
+    */
+    inline POV HatToPOV(int hatX, int hatY)
+    {
+        int horizontal = (hatX < 0) ? static_cast<int>(POV::POV_WEST)
+            : (hatX > 0) ? static_cast<int>(POV::POV_EAST) : 0;
+        int vertical = (hatY < 0) ? static_cast<int>(POV::POV_NORTH)
+            : (hatY > 0) ? static_cast<int>(POV::POV_SOUTH) : 0;
+        return static_cast<POV>(vertical | horizontal);
+    }
+
     struct JoystickDescriptor
     {
         int vendor_id;
@@ -74,14 +157,70 @@ namespace JoystickLibrary
         }
     };
 
+    /**
+    * Packs a vendor/product pair into one hashable key.
+    */
+    inline uint32_t DescriptorKey(const JoystickDescriptor& descriptor)
+    {
+        return (uint32_t(descriptor.vendor_id & 0xFFFF) << 16) | uint32_t(descriptor.product_id & 0xFFFF);
+    }
+
     struct JoystickData
     {
         bool alive;
         JoystickState state;
         JoystickHandle handle;
         JoystickDescriptor descriptor;
+#ifndef _WIN32
+        // descriptor plus the backend's stable key, or empty; see InputDevice::GetStableKey
+        std::string stableKey;
+        // `state` is the reader thread's working copy; everyone else reads this
+        SeqLock<JoystickState> published;
+        // guards alive and handle across connect/disconnect of this device
+        std::mutex lock;
+        // every raw event read from the device, oldest overwritten first
+        EventRing events;
+        // age of the state when published and when handed to a getter
+        LatencyHistogram applyLatency;
+        LatencyHistogram queryLatency;
+        // ranges of the axes in state, taken when the device connects
+        AxisRange axisRanges[ABS_CNT];
+        // axis shaping; replaced under lock, read with atomic_load; null if none
+        std::shared_ptr<const ShapingTable> shaping;
+        // filter memory of the shaping, owned by the reader thread
+        InputShaper shaper;
+        // set while shaped axes still have to catch up with their input
+        std::atomic<bool> settling;
+        // read through the enumerator's io_uring instead of its epoll set
+        bool ringReads;
+#endif
     };
 
+#ifndef _WIN32
+    /**
+    * One device's entry in a multi-device capture; see Enumerator::GetAllSnapshots.
+    * state.eventTime holds the kernel timestamp of the report the state reflects.
+    */
+    struct DeviceSnapshot
+    {
+        int id;
+        JoystickDescriptor descriptor;
+        JoystickState state;
+    };
+
+    inline uint64_t ToNanoseconds(const struct timeval& tv)
+    {
+        return uint64_t(tv.tv_sec) * 1000000000ull + uint64_t(tv.tv_usec) * 1000ull;
+    }
+
+    inline uint64_t MonotonicNanoseconds()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+#endif
+
     struct DeviceStateChange
     {
         enum class State
@@ -100,9 +239,4 @@ namespace JoystickLibrary
                 && (dsc.id == id);
         }
     };
-
-    static int NormalizeAxisValue(int val, int min, int max)
-    {
-        return (int)((200.0 / (max - min)) * (val)-100 * ((max + min) / (max - min)));
-    }
 }
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "InputBackend.hpp"
+#include <atomic>
+#include <linux/io_uring.h>
+#include <vector>
+
+namespace JoystickLibrary
+{
+    /**
+    * Device reads through io_uring, for the enumerator's IO_URING reader
+    * mode. Every watched fd keeps a poll linked to a read armed in the
+    * ring, so the kernel fills the read as soon as input arrives, and the
+    * reader reaps whole batches of completions from shared memory and
+    * re-arms them all with one io_uring_enter, instead of a read until
+    * EAGAIN per device. The ring's fd polls readable while completions are
+    * waiting, so it sits in the reader's epoll set next to hotplug.
+    *
+    * Used only from the reader thread. Read buffers belong to the reader
+    * and outlive the devices, so a read still in flight when a device goes
+    * away never lands in freed memory.
+    */
+    class UringReader
+    {
+    public:
+        static const size_t READ_BYTES = InputDevice::MAX_DELIVERY;
+
+        UringReader();
+        ~UringReader();
+        UringReader(UringReader const&) = delete;
+        void operator=(UringReader const&) = delete;
+
+        /**
+        * Sets up the ring.
+        * @param capacity the highest ID + 1 that will be watched
+        * @return false if the kernel does not offer io_uring or it is not permitted.
+        */
+        bool Start(int capacity);
+
+        int GetFd() const { return ring_fd; }
+
+        /**
+        * Starts reading fd on behalf of a device. Takes effect on the next Submit.
+        * @return false if id is out of range.
+        */
+        bool Watch(int id, int fd);
+
+        /**
+        * Stops reading a device's fd. Completions still in flight for it are dropped.
+        */
+        void Unwatch(int id);
+
+        /**
+        * Re-arms a device's read after its completion was handled.
+        */
+        void Arm(int id);
+
+        /**
+        * Takes every waiting read completion and calls f(id, data, result)
+        * for each: result is the number of bytes at data, 0 at end of stream,
+        * or -errno.
+        */
+        template <typename F>
+        void Reap(F f)
+        {
+            struct io_uring_cqe cqe;
+            while (this->next_cqe(cqe))
+            {
+                int id;
+                if (this->complete(cqe, id))
+                    f(id, static_cast<const void *>(this->slots[id]->buffer), cqe.res);
+            }
+        }
+
+        /**
+        * Hands every queued arm and cancel to the kernel.
+        */
+        void Submit();
+
+        /**
+        * Gets how many times io_uring_enter was called. Safe from any thread.
+        */
+        uint64_t GetEnterCount() const { return enters.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot
+        {
+            int fd;
+            uint32_t generation;    // bumped on Unwatch, so stale completions can be told apart
+            int pending;            // reads submitted and not completed yet, of any generation
+            bool watched;
+            bool armWhenIdle;       // watched again while an old read was in flight
+            alignas(8) char buffer[READ_BYTES];
+        };
+
+        struct io_uring_sqe *next_sqe();
+        bool next_cqe(struct io_uring_cqe& cqe);
+        bool complete(const struct io_uring_cqe& cqe, int& id);
+        void arm(int id, Slot& slot);
+
+        int ring_fd;
+        bool skipPollSuccess;
+        // shared with the kernel
+        void *sqRing;
+        size_t sqRingSize;
+        void *cqRing;
+        size_t cqRingSize;
+        struct io_uring_sqe *sqes;
+        size_t sqesSize;
+        unsigned *sqHead;
+        unsigned *sqTail;
+        unsigned sqMask;
+        unsigned *sqArray;
+        unsigned *sqFlags;
+        unsigned *cqHead;
+        unsigned *cqTail;
+        unsigned cqMask;
+        struct io_uring_cqe *cqes;
+        unsigned queued;
+        std::atomic<uint64_t> enters;
+        std::vector<std::unique_ptr<Slot>> slots;
+    };
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "JoystickService.hpp"
+#include "JoystickServiceT.hpp"
 
 namespace JoystickLibrary
 {
@@ -34,7 +34,59 @@ namespace JoystickLibrary
     };
 #endif
 
-    class Xbox360Service : public JoystickService
+#ifdef _WIN32
+    constexpr int XBOX360_BUTTON_BASE = 0;
+#else
+    constexpr int XBOX360_BUTTON_BASE = BTN_SOUTH;
+#endif
+
+    /**
+    * All inputs of one Xbox 360 controller, read at the same moment.
+    * Axis values use the same ranges as the individual getters.
+    */
+    struct Xbox360Snapshot
+    {
+        int leftX;
+        int leftY;
+        int rightX;
+        int rightY;
+        int leftTrigger;
+        int rightTrigger;
+        POV dpad;
+        uint32_t buttons;   /**< Bit (button - XBOX360_BUTTON_BASE) is set while that button is pressed. */
+
+        bool GetButton(Xbox360Button button) const
+        {
+            return ((buttons >> (static_cast<int>(button) - XBOX360_BUTTON_BASE)) & 1) != 0;
+        }
+    };
+
+#ifndef _WIN32
+    struct Xbox360Profile
+    {
+        typedef DescriptorList<
+            Descriptor<0x045E, 0x028E>,     // Microsoft Xbox 360 Controller
+            Descriptor<0x0E6F, 0x0401>,     // Microsoft Xbox 360 Controller
+            Descriptor<0x045E, 0x0291>,     // Microsoft Xbox 360 Wireless Controller
+            Descriptor<0x0E6F, 0x0213>      // Afterglow AX.1 for Xbox 360
+        > Descriptors;
+        typedef CenteredAxis<ABS_X, -32768, 32767> LeftX;
+        typedef CenteredAxis<ABS_Y, -32768, 32767, -1> LeftY;
+        typedef CenteredAxis<ABS_RX, -32768, 32767> RightX;
+        typedef CenteredAxis<ABS_RY, -32768, 32767, -1> RightY;
+        typedef CenteredAxis<ABS_Z, -255, 255> LeftTrigger;
+        typedef CenteredAxis<ABS_RZ, -255, 255> RightTrigger;
+        typedef HatAxis<ABS_HAT0X> Dpad;
+        typedef ButtonList<BTN_SOUTH, BTN_EAST, BTN_NORTH, BTN_WEST, BTN_TR, BTN_TL,
+            BTN_SELECT, BTN_START, BTN_THUMBL, BTN_THUMBR> Buttons;
+    };
+
+    typedef JoystickServiceT<Xbox360Profile> Xbox360ServiceBase;
+#else
+    typedef JoystickService Xbox360ServiceBase;
+#endif
+
+    class Xbox360Service : public Xbox360ServiceBase
     {
     public:
         const std::vector<JoystickDescriptor> XBOX_IDS {
@@ -65,9 +117,17 @@ namespace JoystickLibrary
         bool GetDpad(int joystickID, POV& dpad);
         bool GetButton(int joystickID, Xbox360Button button, bool& buttonVal);
         bool GetButtons(int joystickID, std::map<Xbox360Button, bool>& buttons);
+        bool GetSnapshot(int joystickID, Xbox360Snapshot& snapshot);
+#ifndef _WIN32
+        bool GetSnapshot(const DeviceSnapshot& device, Xbox360Snapshot& snapshot);
+#endif
 
     protected:
+#ifdef _WIN32
         void OnDeviceChanged(DeviceStateChange ds);
+#else
+        void FillSnapshot(const JoystickState& state, Xbox360Snapshot& snapshot) const;
+#endif
 
     private:
         Xbox360Service();
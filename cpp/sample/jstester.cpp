@@ -2,6 +2,8 @@
 #include "Extreme3DProService.hpp"
 #include "Xbox360Service.hpp"
 #include <chrono>
+#include <ctime>
+#include <thread>
 
 using JoystickLibrary::Extreme3DProService;
 using JoystickLibrary::Xbox360Service;
@@ -53,26 +55,60 @@ void XboxAxes(int id)
 }
 
 
+#ifndef _WIN32
+// CPU time of the whole process, reader thread included, while nothing moved
+void ReportIdle(std::clock_t cpuStart, std::chrono::steady_clock::time_point wallStart)
+{
+    double cpu = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    std::cout << "Idle: " << (wall > 0 ? 100.0 * cpu / wall : 0.0) << "% CPU over " << wall << " s" << std::endl;
+}
+#endif
+
 int main()
 {
-    bool s1 = xs.Initialize();
-    bool s = es.Initialize();
+    xs.Initialize();
+    es.Initialize();
+
+#ifdef _WIN32
     std::cout << "Waiting for js plugin" << std::endl;
-    while (xs.GetNumberConnected() < 1);
+    while (xs.GetNumberConnected() < 1)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
 
-#if 1
     while (true)
     {
-        //std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
 
-        auto& a = xs.GetIDs();
+        auto a = xs.GetIDs();
         if (a.size() <= 0)
             continue;
         XboxAxes(a[0]);
     }
-#endif
+#else
+    // joysticks plugged in before startup are counted once this returns
+    JoystickLibrary::Enumerator::GetInstance().WaitUntilReady();
+
+    while (true)
+    {
+        if (xs.GetNumberConnected() < 1)
+        {
+            std::cout << "Waiting for js plugin" << std::endl;
+            xs.WaitForDevice();
+        }
 
-    std::cin.get();
+        auto a = xs.GetIDs();
+        if (a.size() <= 0)
+            continue;
+
+        // sleeps until the reader publishes new input; a quiet second reports idle CPU use
+        std::clock_t cpuStart = std::clock();
+        auto wallStart = std::chrono::steady_clock::now();
+        if (xs.WaitForChange(a[0], 1000))
+            XboxAxes(a[0]);
+        else if (xs.GetNumberConnected() > 0)
+            ReportIdle(cpuStart, wallStart);
+    }
+#endif
 
     return 0;
 }
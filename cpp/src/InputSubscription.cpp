@@ -0,0 +1,115 @@
+#include "InputSubscription.hpp"
+#include <chrono>
+
+using namespace JoystickLibrary;
+
+
+InputSubscription::InputSubscription(const SubscriptionOptions& options)
+    : options(options),
+      queue(options.capacity > 0 ? options.capacity : 1),
+      head(0),
+      count(0),
+      dropped(0),
+      pending(false),
+      closed(false)
+{
+}
+
+bool InputSubscription::Wait(InputEvent& event, int timeoutMs)
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+    auto hasEvent = [this]() { return this->count > 0 || this->closed; };
+
+    if (timeoutMs < 0)
+        this->ready.wait(guard, hasEvent);
+    else if (!this->ready.wait_for(guard, std::chrono::milliseconds(timeoutMs), hasEvent))
+        return false;
+
+    return this->Pop(event);
+}
+
+bool InputSubscription::TryPop(InputEvent& event)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->Pop(event);
+}
+
+uint64_t InputSubscription::GetDropped() const
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->dropped;
+}
+
+void InputSubscription::Close()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->closed = true;
+    }
+    this->ready.notify_all();
+}
+
+bool InputSubscription::Accepts(int id, InputEvent::Type type) const
+{
+    if (this->options.joystickID >= 0 && this->options.joystickID != id)
+        return false;
+    return (this->options.types & static_cast<int>(type)) != 0;
+}
+
+void InputSubscription::Push(const InputEvent& event)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (this->closed)
+        return;
+
+    size_t capacity = this->queue.size();
+    if (this->count == capacity)
+    {
+        if (this->options.policy == OverflowPolicy::COALESCE)
+        {
+            // fold into the queued event for the same control, if any
+            for (size_t i = 0; i < this->count; i++)
+            {
+                InputEvent& queued = this->queue[(this->head + i) % capacity];
+                if (queued.id == event.id && queued.type == event.type && queued.code == event.code)
+                {
+                    queued.value = event.value;
+                    queued.eventTime = event.eventTime;
+                    this->pending = true;
+                    return;
+                }
+            }
+        }
+
+        // drop the oldest
+        this->head = (this->head + 1) % capacity;
+        this->count--;
+        this->dropped++;
+    }
+
+    this->queue[(this->head + this->count) % capacity] = event;
+    this->count++;
+    this->pending = true;
+}
+
+void InputSubscription::Flush()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (!this->pending)
+            return;
+        this->pending = false;
+    }
+    this->ready.notify_all();
+}
+
+bool InputSubscription::Pop(InputEvent& event)
+{
+    if (this->count == 0)
+        return false;
+
+    event = this->queue[this->head];
+    this->head = (this->head + 1) % this->queue.size();
+    this->count--;
+    return true;
+}
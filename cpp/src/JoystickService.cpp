@@ -1,4 +1,5 @@
 #include "JoystickService.hpp"
+#include <chrono>
 #include <iostream>
 
 using namespace JoystickLibrary;
@@ -18,7 +19,15 @@ bool JoystickLibrary::JoystickService::Initialize()
     if (this->initialized)
         return true;
 
+#ifdef _WIN32
     enumerator.RegisterInstance(std::bind(&JoystickService::OnDeviceChanged, this, std::placeholders::_1));
+#else
+    std::vector<JoystickDescriptor> descriptors;
+    if (!this->GetDescriptors(descriptors))
+        enumerator.RegisterInstance(std::bind(&JoystickService::OnDeviceChanged, this, std::placeholders::_1));
+    else
+        this->RouteDescriptors(descriptors);
+#endif
     bool success = enumerator.Start();
     this->initialized = success;
     return success;
@@ -26,105 +35,226 @@ bool JoystickLibrary::JoystickService::Initialize()
 
 int JoystickLibrary::JoystickService::GetNumberConnected() const
 {
-    return this->ids.size();
+    return static_cast<int>(this->ids.Load()->ids.size());
 }
 
-const std::vector<int>& JoystickService::GetIDs() const
+std::vector<int> JoystickService::GetIDs() const
 {
-    return this->ids;
+    return this->ids.Load()->ids;
 }
 
-bool JoystickService::IsValidJoystickID(int id) const
+std::shared_ptr<const JoystickIdSnapshot> JoystickService::GetIDSnapshot() const
 {
-    return std::find(ids.begin(), ids.end(), id) != ids.end();
+    return this->ids.Load();
 }
 
-JoystickState JoystickLibrary::JoystickService::GetState(int id) const
+#ifndef _WIN32
+std::shared_ptr<InputSubscription> JoystickService::Subscribe(int joystickID, SubscriptionOptions options)
 {
-#ifdef _WIN32
-    DIJOYSTATE js;
-    HRESULT hr;
-    hr = enumerator.impl->jsMap[id].handle->GetDeviceState(sizeof(JoystickState), &js);
-    if (FAILED(hr))
-        memset(&js, 0, sizeof(DIJOYSTATE));
-    enumerator.impl->jsMap[id].state = js;
-    return js;
-#else
-    enumerator.impl->jsMapLock.lock();
-    JoystickData& jsData = enumerator.impl->jsMap[id];
-    struct libevdev *dev = jsData.handle.dev;
+    if (!IsValidJoystickID(joystickID))
+        return nullptr;
+
+    options.joystickID = joystickID;
+    return enumerator.Subscribe(options);
+}
+
+void JoystickService::Unsubscribe(const std::shared_ptr<InputSubscription>& subscription)
+{
+    enumerator.Unsubscribe(subscription);
+}
+
+bool JoystickService::GetLatencyStats(int joystickID, LatencyKind kind, LatencyStats& stats) const
+{
+    if (!IsValidJoystickID(joystickID))
+        return false;
+
+    return enumerator.GetLatencyStats(joystickID, kind, stats);
+}
 
-    // read the joystick state
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(jsData.handle.fd, &fds);
-    struct timeval tv = { 0, 0 };
+bool JoystickService::ResetLatencyStats(int joystickID)
+{
+    if (!IsValidJoystickID(joystickID))
+        return false;
 
-    while (select(jsData.handle.fd + 1, &fds, nullptr, nullptr, &tv) > 0)
+    return enumerator.ResetLatencyStats(joystickID);
+}
+
+bool JoystickService::SetAxisShaping(int joystickID, int code, const AxisShaping& shaping)
+{
+    if (!IsValidJoystickID(joystickID))
+        return false;
+
+    return enumerator.SetAxisShaping(joystickID, code, shaping);
+}
+
+const EventRing *JoystickService::GetEventRing(int joystickID) const
+{
+    if (!IsValidJoystickID(joystickID))
+        return nullptr;
+
+    return enumerator.GetEventRing(joystickID);
+}
+
+namespace
+{
+    // An InputWaiter that blocks the calling thread until the reader fires it.
+    class BlockingWaiter : public InputWaiter
     {
-        struct input_event ev;
-        int rc = libevdev_next_event(dev, LIBEVDEV_READ_FLAG_NORMAL | LIBEVDEV_READ_FLAG_BLOCKING, &ev);
+    public:
+        BlockingWaiter()
+            : fired(false)
+        {
+        }
 
-        if (rc == LIBEVDEV_READ_STATUS_SUCCESS)
+        void Fire() override
         {
-            switch (ev.type)
-            {
-                case EV_KEY:
-                    jsData.state.buttons[ev.code] = !!ev.value;
-                    break;
-                case EV_ABS:
-                    jsData.state.axes[ev.code] = ev.value;
-                    break;
-                default:
-                    break;        
-            }
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->fired = true;
+            this->wake.notify_all();
         }
-        else if (rc == LIBEVDEV_READ_STATUS_SYNC)
+
+        // false on timeout, once the waiter is safe to destroy
+        bool Wait(Enumerator& enumerator, int timeoutMs)
         {
-            // joy state became unsync'd, so perform a resync
-            while (true)
             {
-                rc = libevdev_next_event(dev, LIBEVDEV_READ_FLAG_SYNC | LIBEVDEV_READ_FLAG_BLOCKING, &ev);
-                if (rc != LIBEVDEV_READ_STATUS_SYNC)
-                    break;
-                switch (ev.type)
-                {
-                    case EV_KEY:
-                        jsData.state.buttons[ev.code] = !!ev.value;
-                        break;
-                    case EV_ABS:
-                        jsData.state.axes[ev.code] = ev.value;
-                        break;
-                    default:
-                        break;
-                }
+                std::unique_lock<std::mutex> guard(this->lock);
+                auto hasFired = [this]() { return this->fired; };
+
+                if (timeoutMs < 0)
+                    this->wake.wait(guard, hasFired);
+                else if (this->wake.wait_for(guard, std::chrono::milliseconds(timeoutMs), hasFired))
+                    return true;
             }
+            return !this->Cancel(enumerator);
         }
-        else
+
+        // true if removed before firing
+        bool Cancel(Enumerator& enumerator)
+        {
+            if (enumerator.RemoveWaiter(*this))
+                return true;
+
+            // the reader already took the waiter and is about to call Fire
+            std::unique_lock<std::mutex> guard(this->lock);
+            this->wake.wait(guard, [this]() { return this->fired; });
+            return false;
+        }
+
+    private:
+        std::mutex lock;
+        std::condition_variable wake;
+        bool fired;
+    };
+
+    class ConnectWaiter : public BlockingWaiter
+    {
+    public:
+        bool OnDeviceChange(const DeviceStateChange& dsc) override
+        {
+            return dsc.state == DeviceStateChange::State::ADDED;
+        }
+    };
+
+    class ChangeWaiter : public BlockingWaiter
+    {
+    public:
+        ChangeWaiter()
+            : changed(false)
+        {
+        }
+
+        bool Arm(const JoystickState& current) override
         {
-            // set this one to inactive
-            jsData.alive = false;
-            close(jsData.handle.fd);
-            enumerator.connectedJoysticks--;
-
-            // issue callbacks
-            DeviceStateChange dsc;
-            dsc.state = DeviceStateChange::State::REMOVED;
-            dsc.id = id;
-            dsc.descriptor = jsData.descriptor;
-            for (auto callback : enumerator.callbacks)
-                callback(dsc);
-            enumerator.impl->jsMapLock.unlock();
-            return JoystickState();
+            this->baseline = current;
+            return false;
         }
 
-        FD_ZERO(&fds);
-        FD_SET(jsData.handle.fd, &fds);
-        tv = { 0, 100 };
+        bool OnInput(const JoystickState& state) override
+        {
+            this->changed = !state.SameInputs(this->baseline);
+            return this->changed;
+        }
+
+        // only read after the wait is over
+        bool changed;
+
+    private:
+        JoystickState baseline;
+    };
+
+    int Remaining(std::chrono::steady_clock::time_point deadline)
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        return left.count() > 0 ? static_cast<int>(left.count()) : 0;
+    }
+}
+
+bool JoystickService::WaitForDevice(int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true)
+    {
+        // added before checking, so a joystick connecting in between still wakes us
+        ConnectWaiter waiter;
+        enumerator.AddWaiter(waiter, -1);
+        if (GetNumberConnected() > 0)
+        {
+            waiter.Cancel(enumerator);
+            return true;
+        }
+
+        // services track a device before the enumerator fires waiters, but
+        // the connected device may belong to another service
+        if (!waiter.Wait(enumerator, (timeoutMs < 0) ? -1 : Remaining(deadline)))
+            return false;
     }
-    enumerator.impl->jsMapLock.unlock();
+}
+
+bool JoystickService::WaitForChange(int joystickID, int timeoutMs)
+{
+    if (!IsValidJoystickID(joystickID))
+        return false;
+
+    ChangeWaiter waiter;
+    if (!enumerator.AddWaiter(waiter, joystickID))
+        return false;
+
+    // a removal fires the waiter without a change
+    return waiter.Wait(enumerator, timeoutMs) && waiter.changed;
+}
+#endif
+
+bool JoystickService::IsValidJoystickID(int id) const
+{
+    return ids.Contains(id);
+}
+
+JoystickState JoystickLibrary::JoystickService::GetState(int id) const
+{
+#ifdef _WIN32
+    DIJOYSTATE js;
+    HRESULT hr;
+    hr = enumerator.impl->jsMap[id].handle->GetDeviceState(sizeof(JoystickState), &js);
+    if (FAILED(hr))
+        memset(&js, 0, sizeof(DIJOYSTATE));
+    enumerator.impl->jsMap[id].state = js;
+    return js;
+#else
+    // lock-free lookup; entries are never erased, so the pointer stays valid
+    JoystickData *jsData = enumerator.impl->devices.Find(id);
 
-    return enumerator.impl->jsMap[id].state;
+    // the reader thread keeps the state current, so this is only a copy
+    JoystickState state = JoystickState();
+    if (!jsData)
+        return state;
+
+    jsData->published.Load(state);
+    if (state.eventTime && enumerator.impl->queryLatencyTracking.load(std::memory_order_relaxed))
+    {
+        uint64_t now = MonotonicNanoseconds();
+        jsData->queryLatency.Record(now > state.eventTime ? now - state.eventTime : 0);
+    }
+    return state;
 #endif
 }
 
@@ -134,37 +264,35 @@ void JoystickService::ProcessDeviceChange(std::vector<JoystickDescriptor> id_lis
     if (it == id_list.end())
         return;
 
-    auto id_itr = std::find(ids.begin(), ids.end(), dsc.id);
+    this->TrackDevice(dsc);
+}
 
+void JoystickService::TrackDevice(DeviceStateChange dsc)
+{
     if (dsc.state == DeviceStateChange::State::ADDED)
-    {
-        if (id_itr == ids.end())
-            this->ids.push_back(dsc.id);
-    }
+        this->ids.Add(dsc.id);
     else
-    {
-        if (id_itr != ids.end())
-            ids.erase(id_itr);
-    }
+        this->ids.Remove(dsc.id);
 }
 
 #ifndef _WIN32
-// on linux, use ioctl to get initial states for joysticks
+bool JoystickService::GetDescriptors(std::vector<JoystickDescriptor>&) const
+{
+    return false;
+}
+
+void JoystickService::RouteDescriptors(const std::vector<JoystickDescriptor>& descriptors)
+{
+    // an empty list would register for every device
+    if (descriptors.empty())
+        return;
+
+    enumerator.RegisterInstance(std::bind(&JoystickService::OnDeviceChanged, this, std::placeholders::_1), descriptors);
+}
+
 int JoystickLibrary::JoystickService::GetAxis(int id, int axisId) const
 {
-    std::map<int, int> axes = this->GetState(id).axes;
-    // look up a cached value
-    std::map<int, int>::iterator axisEntry = axes.find(axisId);
-    if (axisEntry != axes.end())
-    {
-        // cache hit!
-        return axisEntry->second;
-    }
-    // if there's nothing, retrieve the current value
-    enumerator.impl->jsMapLock.lock();
-    int axisValue = libevdev_get_event_value(enumerator.impl->jsMap[id].handle.dev, EV_ABS, axisId);
-    axes[axisId] = axisValue;
-    enumerator.impl->jsMapLock.unlock();
-    return axisValue;
+    // axes are seeded from the device when it is opened
+    return this->GetState(id).GetAxis(axisId);
 }
 #endif
@@ -1,13 +1,214 @@
 #include "Enumerator.hpp"
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#ifdef JOYSTICK_HAVE_IO_URING
+    #include "UringReader.hpp"
+#else
+namespace JoystickLibrary
+{
+    // built without io_uring kernel headers: Start never creates a ring, so
+    // IO_URING falls back to EPOLL and none of these are reached
+    class UringReader
+    {
+    public:
+        uint64_t GetEnterCount() const { return 0; }
+        bool Watch(int, int) { return false; }
+        void Unwatch(int) { }
+        void Arm(int) { }
+        void Submit() { }
+        template <typename F>
+        void Reap(F) { }
+    };
+}
+#endif
 
 using namespace JoystickLibrary;
 
-constexpr const char *DEVICE_PATH_TEMPLATE = "/dev/input/%s";
-constexpr const char *DEVICE_ADDED = "add";
-constexpr const char *DEVICE_REMOVED = "remove";
+// epoll tokens for the non-joystick fds; joysticks are keyed by their ID
+constexpr uint64_t SHUTDOWN_TOKEN = UINT64_MAX;
+constexpr uint64_t HOTPLUG_TOKEN = UINT64_MAX - 1;
+constexpr uint64_t SETTLE_TOKEN = UINT64_MAX - 2;
+constexpr uint64_t RESCAN_TOKEN = UINT64_MAX - 3;
+constexpr uint64_t URING_TOKEN = UINT64_MAX - 4;
+constexpr int MAX_EPOLL_EVENTS = 16;
+// how often GetAllSnapshots retries before settling for per-device consistency
+constexpr int MAX_CAPTURE_ATTEMPTS = 16;
+// how often smoothed or slew-limited axes advance while their input is still
+constexpr long SETTLE_PERIOD_NS = 4000000;
+// InputWaiter::id of a waiter that is done and waits on the firing list
+constexpr int FIRING_WAITER = -2;
+
+static void ApplyEvent(JoystickState& state, const struct input_event& ev)
+{
+    switch (ev.type)
+    {
+        case EV_KEY:
+            state.SetButton(ev.code, !!ev.value);
+            break;
+        case EV_ABS:
+            state.SetAxis(ev.code, ev.value);
+            break;
+        default:
+            break;
+    }
+}
+
+static void PublishChange(const SubscriberList& subscribers, InputEvent::Type type, int id, int code, int value,
+    const struct input_event& ev)
+{
+    InputEvent event;
+    event.type = type;
+    event.id = id;
+    event.code = code;
+    event.value = value;
+    event.eventTime = ToNanoseconds(ev.time);
+
+    for (auto& subscription : subscribers)
+    {
+        if (subscription->Accepts(id, type))
+            subscription->Push(event);
+    }
+}
+
+// applies an event and, if anyone is subscribed, reports what it changed
+static void ApplyEvent(JoystickState& state, const struct input_event& ev, int id, const SubscriberList *subscribers)
+{
+    if (!subscribers || subscribers->empty())
+    {
+        ApplyEvent(state, ev);
+        return;
+    }
+
+    if (ev.type == EV_ABS)
+    {
+        int old = state.GetAxis(ev.code);
+        ApplyEvent(state, ev);
+        if (old == ev.value)
+            return;
+
+        if (ev.code >= ABS_HAT0X && ev.code <= ABS_HAT3Y)
+        {
+            // hats come as X/Y axis pairs; report the combined direction
+            int hatX = ev.code - ((ev.code - ABS_HAT0X) % 2);
+            POV pov = HatToPOV(state.GetAxis(hatX), state.GetAxis(hatX + 1));
+            PublishChange(*subscribers, InputEvent::Type::POV, id, hatX, static_cast<int>(pov), ev);
+        }
+        else
+        {
+            PublishChange(*subscribers, InputEvent::Type::AXIS, id, ev.code, ev.value, ev);
+        }
+    }
+    else if (ev.type == EV_KEY)
+    {
+        bool old = state.GetButton(ev.code);
+        ApplyEvent(state, ev);
+        if (old != !!ev.value)
+            PublishChange(*subscribers, InputEvent::Type::BUTTON, id, ev.code, !!ev.value, ev);
+    }
+}
+
+static void RecordAge(LatencyHistogram& histogram, uint64_t eventTime)
+{
+    uint64_t now = MonotonicNanoseconds();
+    histogram.Record(now > eventTime ? now - eventTime : 0);
+}
+
+static void SeedRanges(const InputDevice& device, JoystickData& jsData)
+{
+    for (int code = 0; code < ABS_CNT; code++)
+    {
+        AxisRange range = { 0, 0 };
+        if (jsData.state.HasAxis(code))
+            device.GetAxisRange(code, range);
+        jsData.axisRanges[code] = range;
+    }
+}
+
+// a device's identity across reconnects: its descriptor and the backend's stable key
+static std::string StableIdentity(const JoystickDescriptor& descriptor, const std::string& key)
+{
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "%04x:%04x/", descriptor.vendor_id & 0xFFFF, descriptor.product_id & 0xFFFF);
+    return prefix + key;
+}
+
+static void ArmTimer(int timer_fd, long delay_ns)
+{
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(struct itimerspec));
+    spec.it_value.tv_nsec = delay_ns;
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+}
+
+static bool WatchFd(int epoll_fd, int fd, uint64_t token)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(struct epoll_event));
+    ev.events = EPOLLIN;
+    ev.data.u64 = token;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+
+EnumeratorImpl::EnumeratorImpl()
+{
+    epoll_fd = -1;
+    shutdown_fd = -1;
+    rescan_fd = -1;
+    settle_fd = -1;
+    settleArmed = false;
+    shapingVersion.store(0);
+    frameSequence.store(0);
+    queryLatencyTracking.store(false);
+    wakeTime = 0;
+    readerMode = ReaderMode::EPOLL;
+    wakeups.store(0);
+    eventsRead.store(0);
+    for (int id = 0; id < DeviceTable::CAPACITY; id++)
+    {
+        inputWaiters[id] = nullptr;
+        waitable[id] = false;
+    }
+    changeWaiters = nullptr;
+    firingWaiters = nullptr;
+    inputWaiterCount.store(0);
+    ready = false;
+}
 
+EnumeratorImpl::~EnumeratorImpl()
+{
+    if (readerThread.joinable())
+    {
+        // bump the eventfd to break the reader out of epoll_wait
+        uint64_t one = 1;
+        write(shutdown_fd, &one, sizeof(uint64_t));
+        readerThread.join();
+    }
+    if (subscribers)
+    {
+        for (auto& subscription : *subscribers)
+            subscription->Close();
+    }
+    if (recorder)
+        recorder->Close();
+    if (shutdown_fd >= 0)
+        close(shutdown_fd);
+    if (rescan_fd >= 0)
+        close(rescan_fd);
+    if (settle_fd >= 0)
+        close(settle_fd);
+    if (epoll_fd >= 0)
+        close(epoll_fd);
+    devices.ForEach([](int, JoystickData& jsData) {
+        delete jsData.handle.device;
+    });
+}
 
 Enumerator::Enumerator()
 {
@@ -26,20 +227,73 @@ Enumerator::~Enumerator()
 
 void Enumerator::RegisterInstance(DeviceChangeCallback callback)
 {
-    if (callback)
+    if (!callback)
+        return;
+
+    std::lock_guard<std::recursive_mutex> notifyLock(this->impl->notifyLock);
+    {
+        std::lock_guard<std::mutex> lock(this->impl->callbackLock);
+
+        // the scan may have skipped devices nobody wanted until now
+        if (this->callbacks.empty() && !this->impl->routes.empty())
+            this->hotplug_rescan();
+
         this->callbacks.push_back(callback);
+    }
+    this->announce_devices(callback, nullptr);
+}
 
-    for (auto& pair : this->impl->jsMap)
+void Enumerator::RegisterInstance(DeviceChangeCallback callback, const std::vector<JoystickDescriptor>& descriptors)
+{
+    if (descriptors.empty())
     {
-        if (!pair.second.alive)
-            continue;
+        this->RegisterInstance(callback);
+        return;
+    }
+
+    if (!callback)
+        return;
+
+    std::lock_guard<std::recursive_mutex> notifyLock(this->impl->notifyLock);
+    std::unordered_set<uint32_t> keys;
+    {
+        std::lock_guard<std::mutex> lock(this->impl->callbackLock);
+        bool widened = false;
+        for (auto& descriptor : descriptors)
+        {
+            uint32_t key = DescriptorKey(descriptor);
+            if (keys.insert(key).second)
+            {
+                auto& route = this->impl->routes[key];
+                widened = widened || route.empty();
+                route.push_back(callback);
+            }
+        }
+
+        // the scan may have skipped devices nobody wanted until now
+        if (widened && this->callbacks.empty())
+            this->hotplug_rescan();
+    }
+    this->announce_devices(callback, &keys);
+}
+
+void Enumerator::announce_devices(const DeviceChangeCallback& callback, const std::unordered_set<uint32_t> *keys)
+{
+    // tell a new callback about devices connected before it registered
+    this->impl->devices.ForEach([&](int id, JoystickData& jsData) {
+        // descriptors change when a full table hands an ID to another device
+        std::unique_lock<std::mutex> deviceLock(jsData.lock);
+        JoystickDescriptor descriptor = jsData.descriptor;
+        if (!jsData.alive || (keys && !keys->count(DescriptorKey(descriptor))))
+            return;
+        deviceLock.unlock();
 
         DeviceStateChange dsc;
-        dsc.descriptor = pair.second.descriptor;
-        dsc.id = pair.first;
+        dsc.descriptor = descriptor;
+        dsc.id = id;
         dsc.state = DeviceStateChange::State::ADDED;
         callback(dsc);
-    }
+    });
 }
 
 bool Enumerator::Start()
@@ -50,34 +304,50 @@ bool Enumerator::Start()
         return true;
     }
 
-    // init udev
-    this->impl->udev = udev_new();
-    if (!this->impl->udev)
+    // real hardware unless a test or benchmark installed something else
+    if (!this->impl->backend)
+        this->impl->backend.reset(new UdevBackend());
+    if (!this->impl->backend->Start())
         return false;
 
-    this->impl->udev_monitor = udev_monitor_new_from_netlink(this->impl->udev, "udev");
-    if (!this->impl->udev_monitor)
+    // the reader waits on hotplug, the shutdown eventfd and every joystick
+    this->impl->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (this->impl->epoll_fd < 0)
         return false;
 
-    // set monitors 
-    udev_monitor_filter_add_match_subsystem_devtype(this->impl->udev_monitor, "hid", NULL);
-    udev_monitor_filter_add_match_subsystem_devtype(this->impl->udev_monitor, "input", NULL);
-    udev_monitor_enable_receiving(this->impl->udev_monitor);
-    this->impl->udev_mon_fd = udev_monitor_get_fd(this->impl->udev_monitor);
+    this->impl->shutdown_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (this->impl->shutdown_fd < 0)
+        return false;
+
+    if (!WatchFd(this->impl->epoll_fd, this->impl->shutdown_fd, SHUTDOWN_TOKEN))
+        return false;
+    this->impl->rescan_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (this->impl->rescan_fd < 0 || !WatchFd(this->impl->epoll_fd, this->impl->rescan_fd, RESCAN_TOKEN))
+        return false;
+    this->impl->settle_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (this->impl->settle_fd < 0 || !WatchFd(this->impl->epoll_fd, this->impl->settle_fd, SETTLE_TOKEN))
+        return false;
+    int hotplug_fd = this->impl->backend->GetFd();
+    if (hotplug_fd >= 0 && !WatchFd(this->impl->epoll_fd, hotplug_fd, HOTPLUG_TOKEN))
+        return false;
+
+#ifdef JOYSTICK_HAVE_IO_URING
+    if (this->impl->readerMode == ReaderMode::IO_URING)
+    {
+        // without io_uring, e.g. on old kernels or under seccomp, devices stay in the epoll set
+        std::unique_ptr<UringReader> uring(new UringReader());
+        if (uring->Start(DeviceTable::CAPACITY) && WatchFd(this->impl->epoll_fd, uring->GetFd(), URING_TOKEN))
+            this->impl->uring = std::move(uring);
+    }
+#endif
 
     this->started = true;
 
     // initial enumeration
     this->__run_enum();
 
-    // create "self-pipe" to udev selector
-    pipe(this->impl->udev_select_pipe);
-
-    // init udev thread
-    this->impl->deviceListenerThread = std::thread(&Enumerator::udev_thread, this);
-
-    // init evdev thread
-    //this->impl->evdevEventThread = std::thread(&Enumerator::evdev_thread, this);
+    // init reader thread
+    this->impl->readerThread = std::thread(&Enumerator::reader_thread, this);
 
     return true;
 }
@@ -87,186 +357,906 @@ int JoystickLibrary::Enumerator::GetNumberConnected()
     return this->connectedJoysticks;
 }
 
+int Enumerator::GetAllSnapshots(DeviceSnapshot *snapshots, int capacity, uint64_t& captureTime, bool& coherent)
+{
+    int count = 0;
+    coherent = false;
+
+    for (int attempt = 0; attempt < MAX_CAPTURE_ATTEMPTS; attempt++)
+    {
+        uint64_t before = this->impl->frameSequence.load(std::memory_order_acquire);
+        if ((before & 1) && attempt + 1 < MAX_CAPTURE_ATTEMPTS)
+        {
+            // the reader is mid-batch; let it finish
+            std::this_thread::yield();
+            continue;
+        }
+
+        count = 0;
+        captureTime = MonotonicNanoseconds();
+        this->impl->devices.ForEach([&](int id, JoystickData& jsData) {
+            if (count >= capacity)
+                return;
+
+            {
+                std::lock_guard<std::mutex> deviceLock(jsData.lock);
+                if (!jsData.alive)
+                    return;
+                snapshots[count].descriptor = jsData.descriptor;
+            }
+
+            snapshots[count].id = id;
+            jsData.published.Load(snapshots[count].state);
+            count++;
+        });
+
+        // a capture started mid-batch is torn even if the sequence did not move
+        std::atomic_thread_fence(std::memory_order_acquire);
+        coherent = !(before & 1) && this->impl->frameSequence.load(std::memory_order_relaxed) == before;
+        if (coherent)
+            break;
+    }
+
+    return count;
+}
+
+const EventRing *Enumerator::GetEventRing(int id) const
+{
+    const JoystickData *jsData = this->impl->devices.Find(id);
+    return jsData ? &jsData->events : nullptr;
+}
+
+bool Enumerator::GetLatencyStats(int id, LatencyKind kind, LatencyStats& stats) const
+{
+    const JoystickData *jsData = this->impl->devices.Find(id);
+    if (!jsData)
+        return false;
+
+    stats = (kind == LatencyKind::APPLY) ? jsData->applyLatency.GetStats() : jsData->queryLatency.GetStats();
+    return true;
+}
+
+bool Enumerator::GetAxisRange(int id, int code, AxisRange& range) const
+{
+    JoystickData *jsData = this->impl->devices.Find(id);
+    if (!jsData || code < 0 || code >= ABS_CNT)
+        return false;
+
+    std::lock_guard<std::mutex> deviceLock(jsData->lock);
+    if (jsData->axisRanges[code].minimum == jsData->axisRanges[code].maximum)
+        return false;
+
+    range = jsData->axisRanges[code];
+    return true;
+}
+
+bool Enumerator::SetAxisShaping(int id, int code, const AxisShaping& shaping)
+{
+    JoystickData *jsData = this->impl->devices.Find(id);
+    if (!jsData || code < 0 || code >= ABS_CNT)
+        return false;
+
+    std::lock_guard<std::mutex> deviceLock(jsData->lock);
+    std::shared_ptr<ShapingTable> table = std::make_shared<ShapingTable>();
+    if (jsData->shaping)
+        *table = *jsData->shaping;
+    else
+        table->mask = 0;
+
+    uint64_t bit = uint64_t(1) << code;
+    table->version = this->impl->shapingVersion.fetch_add(1) + 1;
+    table->axes[code] = shaping;
+    table->mask = shaping.IsIdentity() ? (table->mask & ~bit) : (table->mask | bit);
+    std::atomic_store(&jsData->shaping, table->mask ? std::shared_ptr<const ShapingTable>(table) : nullptr);
+
+    // have the reader republish the current state through the new shaping
+    jsData->settling.store(true);
+    if (this->impl->settle_fd >= 0)
+        ArmTimer(this->impl->settle_fd, 1);
+    return true;
+}
+
+LatencyStats Enumerator::GetRemovalLatencyStats() const
+{
+    return this->impl->removeLatency.GetStats();
+}
+
+void Enumerator::ResetRemovalLatencyStats()
+{
+    this->impl->removeLatency.Reset();
+}
+
+bool Enumerator::ResetLatencyStats(int id)
+{
+    JoystickData *jsData = this->impl->devices.Find(id);
+    if (!jsData)
+        return false;
+
+    jsData->applyLatency.Reset();
+    jsData->queryLatency.Reset();
+    return true;
+}
+
+void Enumerator::SetLatencyTracking(bool enabled)
+{
+    this->impl->queryLatencyTracking.store(enabled, std::memory_order_relaxed);
+}
+
+bool Enumerator::SetBackend(std::unique_ptr<InputBackend> backend)
+{
+    if (this->started || !backend)
+        return false;
+
+    this->impl->backend = std::move(backend);
+    return true;
+}
+
+bool Enumerator::SetReaderMode(ReaderMode mode)
+{
+    if (this->started)
+        return false;
+
+    this->impl->readerMode = mode;
+    return true;
+}
+
+ReaderMode Enumerator::GetReaderMode() const
+{
+    if (!this->started)
+        return this->impl->readerMode;
+    return this->impl->uring ? ReaderMode::IO_URING : ReaderMode::EPOLL;
+}
+
+ReaderStats Enumerator::GetReaderStats() const
+{
+    ReaderStats stats;
+    stats.wakeups = this->impl->wakeups.load(std::memory_order_relaxed);
+    stats.submits = this->impl->uring ? this->impl->uring->GetEnterCount() : 0;
+    stats.events = this->impl->eventsRead.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool Enumerator::StartRecording(const char *path)
+{
+    std::lock_guard<std::mutex> lock(this->impl->recorderLock);
+    if (this->impl->recorder)
+        return false;
+
+    std::shared_ptr<InputRecorder> recorder = std::make_shared<InputRecorder>();
+    if (!recorder->Open(path))
+        return false;
+
+    // go live first; the recorder ignores a second connect of the same ID,
+    // so a device the reader connects meanwhile is recorded exactly once
+    std::atomic_store(&this->impl->recorder, recorder);
+
+    this->impl->devices.ForEach([&](int id, JoystickData& jsData) {
+        std::lock_guard<std::mutex> deviceLock(jsData.lock);
+        if (!jsData.alive)
+            return;
+
+        JoystickState state;
+        jsData.published.Load(state);
+        recorder->RecordConnect(id, jsData.descriptor, jsData.stableKey, jsData.handle.path, state);
+    });
+    return true;
+}
+
+bool Enumerator::StopRecording()
+{
+    std::shared_ptr<InputRecorder> recorder;
+    {
+        std::lock_guard<std::mutex> lock(this->impl->recorderLock);
+        recorder = this->impl->recorder;
+        if (!recorder)
+            return false;
+        std::atomic_store(&this->impl->recorder, std::shared_ptr<InputRecorder>());
+    }
+
+    // a reader batch still holding the recorder sees it closed and stops writing
+    return recorder->Close();
+}
+
+std::shared_ptr<InputSubscription> Enumerator::Subscribe(const SubscriptionOptions& options)
+{
+    std::shared_ptr<InputSubscription> subscription = std::make_shared<InputSubscription>(options);
+
+    std::lock_guard<std::mutex> lock(this->impl->subscriberLock);
+    std::shared_ptr<SubscriberList> list = std::make_shared<SubscriberList>();
+    if (this->impl->subscribers)
+        *list = *this->impl->subscribers;
+    list->push_back(subscription);
+    std::atomic_store(&this->impl->subscribers, std::shared_ptr<const SubscriberList>(list));
+    return subscription;
+}
+
+void Enumerator::Unsubscribe(const std::shared_ptr<InputSubscription>& subscription)
+{
+    if (!subscription)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->impl->subscriberLock);
+        if (this->impl->subscribers)
+        {
+            std::shared_ptr<SubscriberList> list = std::make_shared<SubscriberList>(*this->impl->subscribers);
+            list->erase(std::remove(list->begin(), list->end(), subscription), list->end());
+            std::atomic_store(&this->impl->subscribers, std::shared_ptr<const SubscriberList>(list));
+        }
+    }
+    subscription->Close();
+}
+
 void Enumerator::__run_enum(const void *context)
 {
-    int fd;
-    struct libevdev *dev;
     const char *devnode_path;
 
     if (!started || !context)
         return;
 
     devnode_path = (const char *) context;
-    if ((fd = open(devnode_path, O_RDONLY)) < 0)
-        return;
-        
-    if (libevdev_new_from_fd(fd, &dev) < 0)
+
+    // rescans list connected devices again; skip them without opening
+    auto known = this->impl->devnodeIndex.find(devnode_path);
+    if (known != this->impl->devnodeIndex.end())
     {
-        close(fd);
+        const JoystickData *connected = this->impl->devices.Find(known->second);
+        if (connected && connected->alive && strcmp(connected->handle.path, devnode_path) == 0)
+            return;
+    }
+
+    std::unique_ptr<InputDevice> device = this->impl->backend->Open(devnode_path);
+    if (!device)
         return;
+
+    JoystickDescriptor descriptor = device->GetDescriptor();
+    std::string key;
+    if (device->GetStableKey(key))
+        key = StableIdentity(descriptor, key);
+
+    // a device seen before gets its old ID back
+    int id = this->device_lookup(devnode_path, descriptor, key);
+    JoystickData *jsData = (id >= 0) ? this->impl->devices.Find(id) : nullptr;
+    if (jsData && jsData->alive)
+    {
+        // a repeated add, or a second device claiming the same identity
+        if (strcmp(jsData->handle.path, devnode_path) == 0)
+            return;
+        jsData = nullptr;
+    }
+
+    if (!jsData)
+    {
+        id = this->device_allocate();
+        if (id < 0)
+        {
+            // out of table space
+            return;
+        }
+
+        jsData = this->impl->devices.Find(id);
+        if (jsData)
+        {
+            // the table is full; the longest-disconnected device gives up its ID
+            std::lock_guard<std::mutex> deviceLock(jsData->lock);
+            auto it = this->impl->stableIndex.find(jsData->stableKey);
+            if (it != this->impl->stableIndex.end() && it->second == id)
+                this->impl->stableIndex.erase(it);
+
+            jsData->descriptor = descriptor;
+            jsData->stableKey = key;
+            jsData->state = JoystickState();
+            jsData->events.Reset();
+            std::atomic_store(&jsData->shaping, std::shared_ptr<const ShapingTable>());
+            jsData->applyLatency.Reset();
+            jsData->queryLatency.Reset();
+        }
+        else
+        {
+            // new device - publish a disconnected entry, then connect it
+            std::unique_ptr<JoystickData> entry(new JoystickData());
+            entry->alive = false;
+            entry->descriptor = descriptor;
+            entry->stableKey = key;
+            if (!this->impl->devices.Insert(id, std::move(entry)))
+                return;
+            jsData = this->impl->devices.Find(id);
+        }
     }
-            
-    int vendor_id = libevdev_get_id_vendor(dev);
-    int product_id =  libevdev_get_id_product(dev);
+
+    this->device_connect(id, *jsData, std::move(device), devnode_path);
+}
+
+void Enumerator::__run_remove(const void *context)
+{
+    if (!started || !context)
+        return;
     
-    impl->jsMapLock.lock();
-    // check for device was previously connected
-    for (auto& pair : this->impl->jsMap)
+    const char *removed_name = (const char *)context;
+
+    auto it = this->impl->devnodeIndex.find(removed_name);
+    if (it == this->impl->devnodeIndex.end())
+        return;
+
+    JoystickData *jsData = this->impl->devices.Find(it->second);
+    if (jsData && jsData->alive && strcmp(removed_name, jsData->handle.path) == 0)
+        this->device_remove(it->second, *jsData);
+}
+
+void Enumerator::reader_thread()
+{
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+
+    // first run enumeration //
+    this->hotplug_scan();
     {
-        bool devnode_match = strcmp(pair.second.handle.path, devnode_path) == 0; 
+        std::lock_guard<std::mutex> lock(this->impl->readyLock);
+        this->impl->ready = true;
+    }
+    this->impl->readyCondition.notify_all();
 
-        bool id_match = (vendor_id == pair.second.descriptor.vendor_id)
-            && (product_id == pair.second.descriptor.product_id);
+    // steady state //
+    while (true)
+    {
+        // reads posted or cancelled since the last wait go to the kernel in one call
+        if (this->impl->uring)
+            this->impl->uring->Submit();
 
-        if (devnode_match && id_match)
+        int ret = epoll_wait(this->impl->epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+        if (ret < 0)
         {
-            if (pair.second.alive)
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        this->impl->wakeups.fetch_add(1, std::memory_order_relaxed);
+
+        // bracket the batch so multi-device captures can tell it apart
+        this->impl->frameSequence.fetch_add(1, std::memory_order_acq_rel);
+        this->impl->wakeTime = MonotonicNanoseconds();
+        for (int i = 0; i < ret; i++)
+        {
+            uint64_t token = events[i].data.u64;
+            if (token == SHUTDOWN_TOKEN)
             {
-                libevdev_free(dev);
-                impl->jsMapLock.unlock();
+                this->impl->frameSequence.fetch_add(1, std::memory_order_release);
                 return;
             }
-
-            // release old handle
-            libevdev_free(pair.second.handle.dev);
-            
-            // re-enable
-            pair.second.handle.fd = fd;
-            pair.second.handle.dev = dev;
-            pair.second.alive = true;
-            this->connectedJoysticks++;
-
-            // issue callbacks
-            DeviceStateChange dsc;
-            dsc.descriptor= { vendor_id, product_id };
-            dsc.id = pair.first;
-            dsc.state = DeviceStateChange::State::ADDED;
-            for (auto callback : this->callbacks)
-                callback(dsc);
-            impl->jsMapLock.unlock();
-            return;
+            else if (token == HOTPLUG_TOKEN)
+                this->hotplug_receive();
+            else if (token == SETTLE_TOKEN)
+                this->settle_tick();
+            else if (token == URING_TOKEN)
+                this->ring_reap();
+            else if (token == RESCAN_TOKEN)
+            {
+                uint64_t count;
+                read(this->impl->rescan_fd, &count, sizeof(uint64_t));
+                this->hotplug_scan();
+            }
+            else
+                this->device_read(static_cast<int>(token), (events[i].events & (EPOLLHUP | EPOLLERR)) != 0);
         }
+        this->impl->frameSequence.fetch_add(1, std::memory_order_release);
     }
+}
 
-    // new device - add to map
-    JoystickHandle new_handle;
-    memset(&new_handle, 0, sizeof(JoystickHandle));
-    new_handle.dev = dev;
-    new_handle.fd = fd;
-    strncpy(new_handle.path, devnode_path, sizeof(new_handle.path));
+void Enumerator::hotplug_filter()
+{
+    // joysticks only, and only the routed descriptors unless a callback wants every device
+    DeviceFilter filter;
+    filter.joysticksOnly = true;
+    {
+        std::lock_guard<std::mutex> lock(this->impl->callbackLock);
+        filter.everyDescriptor = !this->callbacks.empty() || this->impl->routes.empty();
+        for (const auto& route : this->impl->routes)
+            filter.descriptors.insert(route.first);
+    }
+    this->impl->backend->SetFilter(filter);
+}
+
+void Enumerator::hotplug_rescan()
+{
+    // before Start, the first scan picks the new callbacks up anyway
+    if (this->impl->rescan_fd < 0)
+        return;
+
+    uint64_t one = 1;
+    write(this->impl->rescan_fd, &one, sizeof(uint64_t));
+}
+
+void Enumerator::hotplug_scan()
+{
+    this->hotplug_filter();
+
+    std::vector<std::string> paths;
+    this->impl->backend->Scan(paths);
+
+    for (const auto& path : paths)
+        this->__run_enum(path.c_str());
+}
+
+void Enumerator::hotplug_receive()
+{
+    std::vector<HotplugEvent> events;
+    this->impl->backend->Receive(events);
+
+    for (const auto& event : events)
+    {
+        if (event.action == HotplugEvent::Action::ADDED)
+            this->__run_enum(event.path.c_str());
+        else
+            this->__run_remove(event.path.c_str());
+    }
+}
+
+int Enumerator::device_lookup(const char *path, const JoystickDescriptor& descriptor, const std::string& key) const
+{
+    if (!key.empty())
+    {
+        auto it = this->impl->stableIndex.find(key);
+        return (it != this->impl->stableIndex.end()) ? it->second : -1;
+    }
+
+    // without a stable identity, only the same descriptor at the same devnode is the same device
+    auto it = this->impl->devnodeIndex.find(path);
+    if (it == this->impl->devnodeIndex.end())
+        return -1;
+
+    const JoystickData *jsData = this->impl->devices.Find(it->second);
+    if (!jsData || !jsData->stableKey.empty() || !(jsData->descriptor == descriptor))
+        return -1;
+    return it->second;
+}
+
+int Enumerator::device_allocate()
+{
+    if (this->nextJoystickID < DeviceTable::CAPACITY)
+        return this->nextJoystickID++;
+
+    // only disconnected IDs are queued; device_connect takes reconnected ones out
+    if (this->impl->retiredIDs.empty())
+        return -1;
+
+    int id = this->impl->retiredIDs.front();
+    this->impl->retiredIDs.pop_front();
+    return id;
+}
+
+void Enumerator::device_connect(int id, JoystickData& jsData, std::unique_ptr<InputDevice> device, const char *path)
+{
+    std::unique_lock<std::mutex> deviceLock(jsData.lock);
+    if (strcmp(jsData.handle.path, path) != 0)
+    {
+        // came back under another devnode; the old one may go to another device
+        auto it = this->impl->devnodeIndex.find(jsData.handle.path);
+        if (it != this->impl->devnodeIndex.end() && it->second == id)
+            this->impl->devnodeIndex.erase(it);
+
+        memset(jsData.handle.path, 0, sizeof(jsData.handle.path));
+        strncpy(jsData.handle.path, path, sizeof(jsData.handle.path) - 1);
+    }
+    this->impl->devnodeIndex[path] = id;
+    if (!jsData.stableKey.empty())
+        this->impl->stableIndex.emplace(jsData.stableKey, id);
+
+    // back in use, so no longer up for recycling; this keeps every ID in the queue at most once
+    auto retired = std::find(this->impl->retiredIDs.begin(), this->impl->retiredIDs.end(), id);
+    if (retired != this->impl->retiredIDs.end())
+        this->impl->retiredIDs.erase(retired);
+
+    jsData.handle.device = device.release();
+    jsData.alive = true;
+    jsData.handle.device->Seed(jsData.state);
+    SeedRanges(*jsData.handle.device, jsData);
+    jsData.shaper.Reset();
+    this->device_publish(id, jsData, std::atomic_load(&jsData.shaping).get());
+    int read_fd = this->impl->uring ? jsData.handle.device->TakeReads() : -1;
+    jsData.ringReads = read_fd >= 0 && this->impl->uring->Watch(id, read_fd);
+    if (!jsData.ringReads)
+        WatchFd(this->impl->epoll_fd, jsData.handle.device->GetFd(), id);
+    this->connectedJoysticks++;
+    this->record_connect(id, jsData);
+    deviceLock.unlock();
+
+    // callbacks may start waiting on the device right away
+    {
+        std::lock_guard<std::mutex> lock(this->impl->waiterLock);
+        this->impl->waitable[id] = true;
+    }
 
-    this->impl->jsMap[this->nextJoystickID] = { };
-    this->impl->jsMap[this->nextJoystickID].alive = true;
-    this->impl->jsMap[this->nextJoystickID].handle = new_handle;
-    this->impl->jsMap[this->nextJoystickID].descriptor = { vendor_id, product_id };
-    
     // issue callbacks
     DeviceStateChange dsc;
-    dsc.descriptor= { vendor_id, product_id };
-    dsc.id = this->nextJoystickID;
+    dsc.descriptor = jsData.descriptor;
+    dsc.id = id;
     dsc.state = DeviceStateChange::State::ADDED;
-    for (auto callback : this->callbacks)
-        callback(dsc);
+    this->notify_device_change(dsc);
+    this->waiter_notify(dsc);
+}
 
-    this->nextJoystickID++;
-    this->connectedJoysticks++;
-    impl->jsMapLock.unlock();
+void Enumerator::device_read(int id, bool hangup)
+{
+    // only this thread connects or disconnects devices, so `alive` and
+    // `handle` can be read here without the device lock
+    JoystickData *jsData = this->impl->devices.Find(id);
+    if (!jsData || !jsData->alive)
+        return;
+
+    InputDevice *device = jsData->handle.device;
+    struct input_event ev;
+    ReadStatus rc;
+    uint64_t count = 0;
+
+    std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&this->impl->subscribers);
+    std::shared_ptr<InputRecorder> recorder = std::atomic_load(&this->impl->recorder);
+    std::shared_ptr<const ShapingTable> shaping = std::atomic_load(&jsData->shaping);
+
+    // drain everything the kernel has queued for this device
+    while (true)
+    {
+        rc = device->Next(ev, false);
+
+        if (rc == ReadStatus::SUCCESS)
+        {
+            count++;
+            jsData->events.Push(ev);
+            if (recorder)
+                recorder->RecordEvent(id, ev);
+
+            // publish whole frames so readers never see half of a report
+            if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+            {
+                jsData->state.eventTime = ToNanoseconds(ev.time);
+                this->device_publish(id, *jsData, shaping.get());
+                RecordAge(jsData->applyLatency, jsData->state.eventTime);
+            }
+            else
+                ApplyEvent(jsData->state, ev, id, subscribers.get());
+        }
+        else if (rc == ReadStatus::SYNC)
+        {
+            // joy state became unsync'd, so perform a resync
+            jsData->events.Push(ev);
+            if (recorder)
+                recorder->RecordEvent(id, ev);
+            count++;
+
+            // the delta is stamped by the SYN_REPORT that closes it, like any other frame
+            uint64_t resyncTime = ToNanoseconds(ev.time);
+            while (device->Next(ev, true) == ReadStatus::SYNC)
+            {
+                count++;
+                jsData->events.Push(ev);
+                if (recorder)
+                    recorder->RecordEvent(id, ev);
+                if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+                    resyncTime = ToNanoseconds(ev.time);
+                else
+                    ApplyEvent(jsData->state, ev, id, subscribers.get());
+            }
+            jsData->state.eventTime = resyncTime;
+            this->device_publish(id, *jsData, shaping.get());
+            RecordAge(jsData->applyLatency, jsData->state.eventTime);
+        }
+        else
+        {
+            if (rc == ReadStatus::FAILED)
+                this->device_remove(id, *jsData);
+            break;
+        }
+    }
+
+    this->impl->eventsRead.fetch_add(count, std::memory_order_relaxed);
+
+    // an unplugged evdev node hangs up; whatever it queued before that was read above
+    if (hangup && jsData->alive)
+        this->device_remove(id, *jsData);
+
+    // wake subscribers once per drained batch
+    if (subscribers)
+    {
+        for (auto& subscription : *subscribers)
+            subscription->Flush();
+    }
 }
 
-void Enumerator::__run_remove(const void *context)
+void Enumerator::device_publish(int id, JoystickData& jsData, const ShapingTable *shaping)
+{
+    if (!shaping)
+    {
+        jsData.published.Store(jsData.state);
+        jsData.settling.store(false, std::memory_order_relaxed);
+    }
+    else
+    {
+        // readers see shaped axes in place of the raw ones
+        JoystickState shaped = jsData.state;
+        bool settling = jsData.shaper.Update(*shaping, jsData.axisRanges, jsData.state, MonotonicNanoseconds(), shaped);
+        jsData.published.Store(shaped);
+        jsData.settling.store(settling, std::memory_order_relaxed);
+        if (settling)
+            this->settle_arm();
+    }
+
+    // pairs with the fence in AddWaiter: either it sees this state or we see its waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->impl->inputWaiterCount.load(std::memory_order_relaxed) > 0)
+        this->waiter_input(id, jsData);
+}
+
+void Enumerator::settle_arm()
 {
-    if (!started || context)
+    if (this->impl->settleArmed)
         return;
-    
-    const char *removed_name = (const char *)context;
 
-    for (auto& pair : this->impl->jsMap)
+    ArmTimer(this->impl->settle_fd, SETTLE_PERIOD_NS);
+    this->impl->settleArmed = true;
+}
+
+void Enumerator::settle_tick()
+{
+    uint64_t expirations;
+    if (read(this->impl->settle_fd, &expirations, sizeof(uint64_t)) < 0 && errno == EAGAIN)
+        return;
+    this->impl->settleArmed = false;
+
+    this->impl->devices.ForEach([&](int id, JoystickData& jsData) {
+        if (jsData.alive && jsData.settling.load())
+            this->device_publish(id, jsData, std::atomic_load(&jsData.shaping).get());
+    });
+}
+
+void Enumerator::device_remove(int id, JoystickData& jsData)
+{
+    // set this one to inactive
     {
-        if (!pair.second.alive)
-            continue;
+        std::lock_guard<std::mutex> deviceLock(jsData.lock);
+        jsData.alive = false;
+        if (jsData.ringReads)
+            this->impl->uring->Unwatch(id);
+        else
+            epoll_ctl(this->impl->epoll_fd, EPOLL_CTL_DEL, jsData.handle.device->GetFd(), nullptr);
+        delete jsData.handle.device;
+        jsData.handle.device = nullptr;
+        this->connectedJoysticks--;
+        this->record_disconnect(id);
+    }
+    this->impl->retiredIDs.push_back(id);
+
+    // issue callbacks
+    DeviceStateChange dsc;
+    dsc.state = DeviceStateChange::State::REMOVED;
+    dsc.id = id;
+    dsc.descriptor = jsData.descriptor;
+    this->notify_device_change(dsc);
+    this->waiter_notify(dsc);
+    RecordAge(this->impl->removeLatency, this->impl->wakeTime);
+}
+
+void Enumerator::ring_reap()
+{
+    UringReader& uring = *this->impl->uring;
+    uring.Reap([&](int id, const void *bytes, int result) {
+        JoystickData *jsData = this->impl->devices.Find(id);
+        if (!jsData || !jsData->alive)
+            return;
 
-        if (strcmp(removed_name, pair.second.handle.path) == 0)
+        if (result > 0)
         {
-            // found the removed device
-            pair.second.alive = false;
-            close(pair.second.handle.fd);
-            this->connectedJoysticks--;
-
-            // issue callbacks
-            DeviceStateChange dsc;
-            dsc.state = DeviceStateChange::State::REMOVED;
-            dsc.id = pair.first;
-            dsc.descriptor = pair.second.descriptor;
-            for (auto callback : this->callbacks)
-                callback(dsc);
+            jsData->handle.device->Deliver(bytes, static_cast<size_t>(result));
+            this->device_read(id, false);
         }
+        else if (result != -EAGAIN && result != -EINTR)
+        {
+            // end of stream, or the device is gone (-ENODEV once an evdev node is unplugged)
+            this->device_remove(id, *jsData);
+        }
+
+        if (jsData->alive)
+            uring.Arm(id);
+    });
+}
+
+void Enumerator::record_connect(int id, const JoystickData& jsData)
+{
+    std::shared_ptr<InputRecorder> recorder = std::atomic_load(&this->impl->recorder);
+    if (recorder)
+        recorder->RecordConnect(id, jsData.descriptor, jsData.stableKey, jsData.handle.path, jsData.state);
+}
+
+void Enumerator::record_disconnect(int id)
+{
+    std::shared_ptr<InputRecorder> recorder = std::atomic_load(&this->impl->recorder);
+    if (recorder)
+        recorder->RecordDisconnect(id);
+}
+
+void Enumerator::notify_device_change(const DeviceStateChange& dsc)
+{
+    std::lock_guard<std::recursive_mutex> notifyLock(this->impl->notifyLock);
+
+    // run the callbacks on a copy, so they can register others without deadlocking
+    std::vector<DeviceChangeCallback> notified;
+    {
+        std::lock_guard<std::mutex> lock(this->impl->callbackLock);
+        notified = this->callbacks;
+        auto route = this->impl->routes.find(DescriptorKey(dsc.descriptor));
+        if (route != this->impl->routes.end())
+            notified.insert(notified.end(), route->second.begin(), route->second.end());
     }
-    
+
+    for (auto& callback : notified)
+        callback(dsc);
 }
 
-void Enumerator::udev_thread()
+bool Enumerator::WaitUntilReady(int timeoutMs)
 {
-    udev_enumerate *enumerate;
-    udev_list_entry *devices, *dev_list_entry;
- 
-    // first run enumeration //
-	enumerate = udev_enumerate_new(impl->udev);
-	udev_enumerate_add_match_sysname(enumerate, "event[0-9]*");
-    udev_enumerate_add_match_subsystem(enumerate, "input");
-	udev_enumerate_scan_devices(enumerate);
-	devices = udev_enumerate_get_list_entry(enumerate);
-
-	udev_list_entry_foreach(dev_list_entry, devices) 
-	{
-		const char *path;
-        udev_device *dev;
-		
-		path = udev_list_entry_get_name(dev_list_entry);
-		dev = udev_device_new_from_syspath(impl->udev, path);
-        this->__run_enum(udev_device_get_devnode(dev));
-		udev_device_unref(dev);
-	}
-    udev_enumerate_unref(enumerate);
+    if (!this->started)
+        return false;
 
-    // steady state //
-	while (this->started) 
-    {
-		fd_set fds;
-		int ret;
-        const char *devnode;
-        const char *action;
-        udev_device *dev;
-		
-		FD_ZERO(&fds);
-        int udev_fd = this->impl->udev_mon_fd;
-        int pipe_fd = this->impl->udev_select_pipe[0];
-		FD_SET(udev_fd, &fds);
-        FD_SET(pipe_fd, &fds);
-		ret = select(std::max(udev_fd, pipe_fd) + 1, &fds, NULL, NULL, NULL);
-
-        // if we receive something and `started` is false, it's probably
-        // the "break-out-of-select" signal, so exit the loop immediately
-        if (!this->started)
-            break;
+    std::unique_lock<std::mutex> lock(this->impl->readyLock);
+    auto isReady = [this]() { return this->impl->ready; };
 
-		if (ret <= 0 || !FD_ISSET(this->impl->udev_mon_fd, &fds))
-            continue;
+    if (timeoutMs < 0)
+        this->impl->readyCondition.wait(lock, isReady);
+    else if (!this->impl->readyCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), isReady))
+        return false;
 
-        dev = udev_monitor_receive_device(this->impl->udev_monitor);
-        if (!dev)
-            continue;
-        
-        devnode = udev_device_get_devnode(dev);
-        if (!devnode)
-            continue;
+    return true;
+}
 
-        if (strstr(devnode, "event") == NULL)
-            continue;
+bool Enumerator::AddWaiter(InputWaiter& waiter, int id)
+{
+    if (id >= DeviceTable::CAPACITY || waiter.linked)
+        return false;
+
+    const JoystickData *jsData = nullptr;
+    if (id >= 0)
+    {
+        jsData = this->impl->devices.Find(id);
+        if (!jsData)
+            return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->impl->waiterLock);
+    InputWaiter **head = &this->impl->changeWaiters;
+    if (id >= 0)
+    {
+        if (!this->impl->waitable[id])
+            return false;
+
+        // count first, so a state published after the one Arm sees is passed to OnInput
+        this->impl->inputWaiterCount.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        JoystickState current;
+        jsData->published.Load(current);
+        if (waiter.Arm(current))
+        {
+            this->impl->inputWaiterCount.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        head = &this->impl->inputWaiters[id];
+    }
+
+    waiter.id = id;
+    waiter.prev = nullptr;
+    waiter.next = *head;
+    if (*head)
+        (*head)->prev = &waiter;
+    *head = &waiter;
+    waiter.linked = true;
+    return true;
+}
+
+bool Enumerator::RemoveWaiter(InputWaiter& waiter)
+{
+    std::lock_guard<std::mutex> lock(this->impl->waiterLock);
+    if (!waiter.linked)
+        return false;
+
+    if (waiter.id == FIRING_WAITER)
+        this->waiter_unlink(this->impl->firingWaiters, waiter);
+    else if (waiter.id >= 0)
+    {
+        this->waiter_unlink(this->impl->inputWaiters[waiter.id], waiter);
+        this->impl->inputWaiterCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    else
+        this->waiter_unlink(this->impl->changeWaiters, waiter);
+    return true;
+}
 
-        action = udev_device_get_action(dev);
-        if (strcmp(action, DEVICE_ADDED) == 0)
-            this->__run_enum(devnode);
-        
-        udev_device_unref(dev);
-	}
+void Enumerator::waiter_unlink(InputWaiter *&head, InputWaiter& waiter)
+{
+    if (waiter.prev)
+        waiter.prev->next = waiter.next;
+    else
+        head = waiter.next;
+    if (waiter.next)
+        waiter.next->prev = waiter.prev;
+    waiter.linked = false;
+}
+
+// moves the waiters of a list that `done` accepts onto the firing list; under waiterLock
+template <typename Done>
+int Enumerator::waiter_take(InputWaiter *&head, Done done)
+{
+    int count = 0;
+    InputWaiter *waiter = head;
+    while (waiter)
+    {
+        InputWaiter *next = waiter->next;
+        if (done(*waiter))
+        {
+            waiter_unlink(head, *waiter);
+            waiter->id = FIRING_WAITER;
+            waiter->prev = nullptr;
+            waiter->next = this->impl->firingWaiters;
+            if (waiter->next)
+                waiter->next->prev = waiter;
+            this->impl->firingWaiters = waiter;
+            waiter->linked = true;
+            count++;
+        }
+        waiter = next;
+    }
+    return count;
+}
+
+void Enumerator::waiter_fire()
+{
+    while (true)
+    {
+        // unlinked one at a time, so a Fire that cancels other waiters never fires them
+        InputWaiter *fired;
+        {
+            std::lock_guard<std::mutex> lock(this->impl->waiterLock);
+            fired = this->impl->firingWaiters;
+            if (!fired)
+                return;
+            waiter_unlink(this->impl->firingWaiters, *fired);
+        }
+
+        // the waiter may be gone once it fired
+        fired->Fire();
+    }
+}
+
+void Enumerator::waiter_input(int id, JoystickData& jsData)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->impl->waiterLock);
+        if (!this->impl->inputWaiters[id])
+            return;
+
+        JoystickState state;
+        jsData.published.Load(state);
+        int count = waiter_take(this->impl->inputWaiters[id], [&](InputWaiter& waiter) {
+            return waiter.OnInput(state);
+        });
+        this->impl->inputWaiterCount.fetch_sub(count, std::memory_order_relaxed);
+    }
+    waiter_fire();
+}
+
+void Enumerator::waiter_notify(const DeviceStateChange& dsc)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->impl->waiterLock);
+        if (dsc.state == DeviceStateChange::State::REMOVED && dsc.id >= 0 && dsc.id < DeviceTable::CAPACITY)
+        {
+            // waits on a device end with it, whether or not the waiter cares
+            this->impl->waitable[dsc.id] = false;
+            int count = waiter_take(this->impl->inputWaiters[dsc.id], [&](InputWaiter& waiter) {
+                waiter.OnDeviceChange(dsc);
+                return true;
+            });
+            this->impl->inputWaiterCount.fetch_sub(count, std::memory_order_relaxed);
+        }
+
+        waiter_take(this->impl->changeWaiters, [&](InputWaiter& waiter) {
+            return waiter.OnDeviceChange(dsc);
+        });
+    }
+    waiter_fire();
 }
@@ -2,16 +2,19 @@
 
 using namespace JoystickLibrary;
 
-constexpr int X_MIN = 0;
-constexpr int X_MAX = 1023;
-constexpr int Y_MIN = 0;
-constexpr int Y_MAX = 1023;
-constexpr int Z_MIN = 0;
-constexpr int Z_MAX = 255;
-constexpr int SLIDER_MIN = 255;
-constexpr int SLIDER_MAX = 0;
-
-Extreme3DProService::Extreme3DProService() : JoystickService()
+typedef Extreme3DProProfile Profile;
+
+static_assert(Profile::Descriptors::Matches(0x046D, 0xC215), "Extreme 3D Pro profile lost its descriptor");
+
+// normalization must agree with exact division at every raw value
+static_assert(Profile::X::IsExact(1) && Profile::Y::IsExact(1), "X/Y normalization is not exact");
+static_assert(Profile::ZRot::IsExact(1) && Profile::Slider::IsExact(1), "8-bit axis tables are not exact");
+static_assert(Profile::X::Normalize(0) == -100 && Profile::X::Normalize(1023) == 100 && Profile::X::Normalize(511) == 0,
+    "X must span -100..100");
+static_assert(Profile::Y::Normalize(0) == 100 && Profile::Y::Normalize(1023) == -100, "Y must read forwards as positive");
+static_assert(Profile::Slider::Normalize(255) == 0 && Profile::Slider::Normalize(0) == 100, "slider must span 0..100");
+
+Extreme3DProService::Extreme3DProService() : Extreme3DProServiceBase()
 { 
 }
 
@@ -19,98 +22,71 @@ Extreme3DProService::~Extreme3DProService()
 {
 }
 
-void Extreme3DProService::OnDeviceChanged(DeviceStateChange ds)
-{
-    this->ProcessDeviceChange(EXTREME_3D_PRO_IDS, ds);
-}
-
 bool Extreme3DProService::GetX(int joystickID, int& x)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    x = NormalizeAxisValue(this->GetAxis(joystickID, ABS_X), X_MIN, X_MAX);
-    return true;
+    return this->ReadAxis<Profile::X>(joystickID, x);
 }
 
 bool Extreme3DProService::GetY(int joystickID, int& y)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    y =  -NormalizeAxisValue(this->GetAxis(joystickID, ABS_Y), Y_MIN, Y_MAX);
-    return true;
+    return this->ReadAxis<Profile::Y>(joystickID, y);
 }
 
 bool Extreme3DProService::GetZRot(int joystickID, int& zRot)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    zRot = NormalizeAxisValue(this->GetAxis(joystickID, ABS_RZ), Z_MIN, Z_MAX);
-    return true;
+    return this->ReadAxis<Profile::ZRot>(joystickID, zRot);
 }
 
 bool Extreme3DProService::GetSlider(int joystickID, int& slider)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    slider = 100 + (int) (((100.0 / (SLIDER_MAX - SLIDER_MIN)) * (this->GetAxis(joystickID, ABS_THROTTLE))));
-    return true;
+    return this->ReadAxis<Profile::Slider>(joystickID, slider);
 }
 
 bool Extreme3DProService::GetButton(int joystickID, Extreme3DProButton button, bool& buttonVal)
+{
+    return this->ReadButton(joystickID, static_cast<int>(button), buttonVal);
+}
+
+bool Extreme3DProService::GetButtons(int joystickID, std::map<Extreme3DProButton, bool>& buttons)
 {
     if (!IsValidJoystickID(joystickID))
         return false;
 
-    buttonVal = !!this->GetState(joystickID).buttons[BTN_TRIGGER + static_cast<int>(button)];
+    JoystickState state = this->GetState(joystickID);
+    for (int i = 0; i < Profile::Buttons::COUNT; i++)
+        buttons[static_cast<Extreme3DProButton>(i)] = state.GetButton(Profile::Buttons::Code(i));
     return true;
 }
 
-bool Extreme3DProService::GetButtons(int joystickID, std::map<Extreme3DProButton, bool>& buttons)
+bool Extreme3DProService::GetPOV(int joystickID, POV& pov)
+{
+    return this->ReadHat<Profile::Hat>(joystickID, pov);
+}
+
+void Extreme3DProService::FillSnapshot(const JoystickState& state, Extreme3DProSnapshot& snapshot) const
+{
+    snapshot.x = Profile::X::Read(state);
+    snapshot.y = Profile::Y::Read(state);
+    snapshot.zRot = Profile::ZRot::Read(state);
+    snapshot.slider = Profile::Slider::Read(state);
+    snapshot.pov = Profile::Hat::Read(state);
+    snapshot.buttons = ButtonMask(state);
+}
+
+bool Extreme3DProService::GetSnapshot(int joystickID, Extreme3DProSnapshot& snapshot)
 {
     if (!IsValidJoystickID(joystickID))
         return false;
 
-    for (auto& pair : this->GetState(joystickID).buttons)
-        buttons[static_cast<Extreme3DProButton>(pair.first)] = !!pair.second;
+    FillSnapshot(this->GetState(joystickID), snapshot);
     return true;
 }
 
-bool Extreme3DProService::GetPOV(int joystickID, POV& pov)
+bool Extreme3DProService::GetSnapshot(const DeviceSnapshot& device, Extreme3DProSnapshot& snapshot)
 {
-    if (!IsValidJoystickID(joystickID))
+    if (!Matches(device.descriptor))
         return false;
 
-    POV horizontal, vertical;
-    switch (this->GetAxis(joystickID, ABS_HAT0X))
-    {
-        case -1:
-            horizontal = POV::POV_WEST;
-            break;
-        case 1:
-            horizontal = POV::POV_EAST;
-            break;
-        default:
-            horizontal = POV::POV_NONE;
-            break;
-    }
-
-    switch (this->GetAxis(joystickID, ABS_HAT0Y))
-    {
-        case -1:
-            vertical = POV::POV_NORTH;
-            break;
-        case 1:
-            vertical = POV::POV_SOUTH;
-            break;
-        default:
-            vertical = POV::POV_NONE;
-            break;
-    }
-
-    pov = static_cast<POV>(static_cast<int>(vertical) | static_cast<int>(horizontal));
+    FillSnapshot(device.state, snapshot);
     return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,291 @@
+#include "AxisScale.hpp"
+#include "GameControllerService.hpp"
+
+using namespace JoystickLibrary;
+
+// assumed when the backend does not report an axis range
+constexpr AxisRange DEFAULT_RANGE = { -32768, 32767 };
+
+/*
+* One controller element resolved against a device: which evdev code it
+* reads and how, with every scale and threshold computed at connect time.
+*/
+struct Binding
+{
+    enum class Kind : uint8_t
+    {
+        NONE,
+        KEY,        /**< Pressed while the key is down.                          */
+        THRESHOLD,  /**< Pressed while direction * (axis - threshold) > 0.       */
+        SCALED      /**< Axis value mapped by scale.                             */
+    };
+
+    Kind kind;
+    int code;
+    int threshold;
+    int direction;
+    AxisScale scale;
+    int low;        /**< Output while released, or at the start of the input range. */
+    int high;       /**< Output while pressed, or at the end of the input range.     */
+};
+
+struct GameControllerService::DeviceMapping
+{
+    std::shared_ptr<const ControllerProfile> profile;
+    Binding axes[CONTROLLER_AXIS_COUNT];
+    Binding buttons[CONTROLLER_BUTTON_COUNT];
+};
+
+/*
+* Input numbering of a device as mapping strings count it: axes in code
+* order without the hats, hats by pair, and buttons from BTN_JOYSTICK up
+* followed by the ones below it.
+*/
+struct DeviceLayout
+{
+    std::vector<int> axes;
+    std::vector<int> hats;
+    std::vector<int> buttons;
+
+    explicit DeviceLayout(const JoystickState& state)
+    {
+        for (int code = 0; code < ABS_CNT; code++)
+        {
+            if (state.HasAxis(code) && (code < ABS_HAT0X || code > ABS_HAT3Y))
+                axes.push_back(code);
+        }
+        for (int code = ABS_HAT0X; code <= ABS_HAT3X; code += 2)
+        {
+            if (state.HasAxis(code) || state.HasAxis(code + 1))
+                hats.push_back(code);
+        }
+        for (int code = BTN_JOYSTICK; code < KEY_CNT; code++)
+        {
+            if (state.HasButton(code))
+                buttons.push_back(code);
+        }
+        for (int code = BTN_MISC; code < BTN_JOYSTICK; code++)
+        {
+            if (state.HasButton(code))
+                buttons.push_back(code);
+        }
+    }
+};
+
+static bool IsPressed(const Binding& binding, const JoystickState& state)
+{
+    if (binding.kind == Binding::Kind::KEY)
+        return state.GetButton(binding.code);
+    return binding.direction * (state.GetAxis(binding.code) - binding.threshold) > 0;
+}
+
+static int ReadBinding(const Binding& binding, const JoystickState& state)
+{
+    if (binding.kind != Binding::Kind::SCALED)
+        return IsPressed(binding, state) ? binding.high : binding.low;
+    return binding.scale.Apply(state.GetAxis(binding.code));
+}
+
+// the part of an axis's range a source reads, from its low end to its high end
+static void SourceSpan(const MappingSource& source, const AxisRange& range, int& from, int& to)
+{
+    int center = range.minimum + (range.maximum - range.minimum) / 2;
+    from = source.half ? center : range.minimum;
+    to = (source.half < 0) ? range.minimum : range.maximum;
+    if (source.invert)
+        std::swap(from, to);
+}
+
+static Binding Resolve(const MappingSource& source, const DeviceLayout& layout, const AxisRange *ranges,
+    int low, int high, bool scaled)
+{
+    Binding binding = { Binding::Kind::NONE, 0, 0, 1, AxisScale(), low, high };
+
+    if (source.kind == MappingSource::Kind::BUTTON && source.index < layout.buttons.size())
+    {
+        binding.kind = Binding::Kind::KEY;
+        binding.code = layout.buttons[source.index];
+    }
+    else if (source.kind == MappingSource::Kind::HAT && source.index < layout.hats.size())
+    {
+        // evdev hats are -1/0/1 per direction; up and left are negative
+        bool vertical = (source.hatMask & 0x5) != 0;
+        binding.kind = Binding::Kind::THRESHOLD;
+        binding.code = layout.hats[source.index] + (vertical ? 1 : 0);
+        binding.threshold = 0;
+        binding.direction = (source.hatMask & 0x9) ? -1 : 1;
+    }
+    else if (source.kind == MappingSource::Kind::AXIS && source.index < layout.axes.size())
+    {
+        int code = layout.axes[source.index];
+        AxisRange range = ranges[code];
+        if (range.minimum == range.maximum || !AxisScale::Fits(range.minimum, range.maximum, low, high))
+            range = DEFAULT_RANGE;
+
+        int from, to;
+        SourceSpan(source, range, from, to);
+        if (from == to)
+            return binding;
+
+        binding.code = code;
+        if (scaled)
+        {
+            binding.kind = Binding::Kind::SCALED;
+            binding.scale = AxisScale(from, to, low, high);
+        }
+        else
+        {
+            // pressed past the middle of the span
+            binding.kind = Binding::Kind::THRESHOLD;
+            binding.threshold = from + (to - from) / 2;
+            binding.direction = (to > from) ? 1 : -1;
+        }
+    }
+
+    return binding;
+}
+
+
+GameControllerService::GameControllerService() : JoystickService()
+{
+    mappings = std::make_shared<const MappingTable>();
+}
+
+GameControllerService::~GameControllerService()
+{
+}
+
+bool GameControllerService::AddMapping(const std::string& mapping)
+{
+    std::vector<JoystickDescriptor> added;
+    if (!this->registry.AddMapping(mapping, added))
+        return false;
+
+    this->Route(added);
+    return true;
+}
+
+int GameControllerService::AddMappings(const std::string& mappings)
+{
+    std::vector<JoystickDescriptor> added;
+    int count = this->registry.AddMappings(mappings, added);
+    this->Route(added);
+    return count;
+}
+
+int GameControllerService::AddMappingsFromFile(const char *path)
+{
+    std::vector<JoystickDescriptor> added;
+    int count = this->registry.AddMappingsFromFile(path, added);
+    this->Route(added);
+    return count;
+}
+
+bool GameControllerService::GetAxis(int joystickID, ControllerAxis axis, int& value)
+{
+    int index = static_cast<int>(axis);
+    if (index < 0 || index >= CONTROLLER_AXIS_COUNT || !IsValidJoystickID(joystickID))
+        return false;
+
+    std::shared_ptr<const DeviceMapping> mapping = this->FindMapping(joystickID);
+    if (!mapping || mapping->axes[index].kind == Binding::Kind::NONE)
+        return false;
+
+    value = ReadBinding(mapping->axes[index], this->GetState(joystickID));
+    return true;
+}
+
+bool GameControllerService::GetButton(int joystickID, ControllerButton button, bool& buttonVal)
+{
+    int index = static_cast<int>(button);
+    if (index < 0 || index >= CONTROLLER_BUTTON_COUNT || !IsValidJoystickID(joystickID))
+        return false;
+
+    std::shared_ptr<const DeviceMapping> mapping = this->FindMapping(joystickID);
+    if (!mapping || mapping->buttons[index].kind == Binding::Kind::NONE)
+        return false;
+
+    buttonVal = IsPressed(mapping->buttons[index], this->GetState(joystickID));
+    return true;
+}
+
+bool GameControllerService::GetName(int joystickID, std::string& name)
+{
+    if (!IsValidJoystickID(joystickID))
+        return false;
+
+    std::shared_ptr<const DeviceMapping> mapping = this->FindMapping(joystickID);
+    if (!mapping)
+        return false;
+
+    name = mapping->profile->name;
+    return true;
+}
+
+bool GameControllerService::GetDescriptors(std::vector<JoystickDescriptor>& descriptors) const
+{
+    // routed even while empty; mappings added later are routed as they load
+    this->registry.GetDescriptors(descriptors);
+    return true;
+}
+
+void GameControllerService::OnDeviceChanged(DeviceStateChange ds)
+{
+    std::shared_ptr<DeviceMapping> mapping;
+    if (ds.state == DeviceStateChange::State::ADDED)
+    {
+        std::shared_ptr<const ControllerProfile> profile = this->registry.Find(ds.descriptor);
+        if (!profile)
+            return;
+
+        AxisRange ranges[ABS_CNT];
+        for (int code = 0; code < ABS_CNT; code++)
+        {
+            if (!enumerator.GetAxisRange(ds.id, code, ranges[code]))
+                ranges[code] = { 0, 0 };
+        }
+
+        DeviceLayout layout(this->GetState(ds.id));
+        mapping = std::make_shared<DeviceMapping>();
+        mapping->profile = profile;
+        for (int i = 0; i < CONTROLLER_AXIS_COUNT; i++)
+        {
+            ControllerAxis axis = static_cast<ControllerAxis>(i);
+            bool trigger = axis == ControllerAxis::LeftTrigger || axis == ControllerAxis::RightTrigger;
+            bool vertical = axis == ControllerAxis::LeftY || axis == ControllerAxis::RightY;
+
+            // mapping strings have down positive; flip so forwards is positive
+            int low = trigger ? 0 : (vertical ? 100 : -100);
+            int high = vertical ? -100 : 100;
+            mapping->axes[i] = Resolve(profile->axes[i], layout, ranges, low, high, true);
+        }
+        for (int i = 0; i < CONTROLLER_BUTTON_COUNT; i++)
+            mapping->buttons[i] = Resolve(profile->buttons[i], layout, ranges, 0, 1, false);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(this->mappingLock);
+        std::shared_ptr<MappingTable> table = std::make_shared<MappingTable>(*this->mappings);
+        if (mapping)
+            (*table)[ds.id] = mapping;
+        else
+            table->erase(ds.id);
+        std::atomic_store(&this->mappings, std::shared_ptr<const MappingTable>(table));
+    }
+
+    this->TrackDevice(ds);
+}
+
+std::shared_ptr<const GameControllerService::DeviceMapping> GameControllerService::FindMapping(int joystickID) const
+{
+    std::shared_ptr<const MappingTable> table = std::atomic_load(&this->mappings);
+    auto it = table->find(joystickID);
+    return it != table->end() ? it->second : nullptr;
+}
+
+void GameControllerService::Route(const std::vector<JoystickDescriptor>& added)
+{
+    // before Initialize, GetDescriptors picks them up instead
+    if (this->initialized)
+        this->RouteDescriptors(added);
+}
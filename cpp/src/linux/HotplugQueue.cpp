@@ -0,0 +1,36 @@
+#include "InputBackend.hpp"
+#include <sys/eventfd.h>
+
+using namespace JoystickLibrary;
+
+HotplugQueue::HotplugQueue()
+{
+    notify_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+HotplugQueue::~HotplugQueue()
+{
+    if (notify_fd >= 0)
+        close(notify_fd);
+}
+
+void HotplugQueue::Post(HotplugEvent::Action action, const std::string& path)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->pending.push_back({ action, path });
+
+    uint64_t one = 1;
+    write(this->notify_fd, &one, sizeof(uint64_t));
+}
+
+void HotplugQueue::Receive(std::vector<HotplugEvent>& events)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    // drain the counter together with the list so a later Post re-arms it
+    uint64_t count;
+    read(this->notify_fd, &count, sizeof(uint64_t));
+
+    events.insert(events.end(), this->pending.begin(), this->pending.end());
+    this->pending.clear();
+}
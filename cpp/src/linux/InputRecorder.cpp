@@ -0,0 +1,210 @@
+#include "InputRecording.hpp"
+
+using namespace JoystickLibrary;
+
+// records buffered before each fwrite
+constexpr size_t WRITE_BATCH = 4096;
+
+
+InputRecorder::InputRecorder()
+{
+    file = nullptr;
+    failed = false;
+    recordCount = 0;
+    closing = false;
+    buffer.reserve(WRITE_BATCH);
+    writing.reserve(WRITE_BATCH);
+}
+
+InputRecorder::~InputRecorder()
+{
+    this->Close();
+}
+
+bool InputRecorder::Open(const char *path)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (this->file)
+        return false;
+
+    this->file = fopen(path, "wbe");
+    if (!this->file)
+        return false;
+
+    RecordingHeader header;
+    memset(&header, 0, sizeof(RecordingHeader));
+    memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.recordSize = sizeof(RecordedEvent);
+    header.deviceSize = sizeof(RecordedDevice);
+    header.startTime = MonotonicNanoseconds();
+
+    this->failed = fwrite(&header, sizeof(RecordingHeader), 1, this->file) != 1;
+    if (this->failed)
+        return false;
+
+    this->closing = false;
+    this->writer = std::thread(&InputRecorder::WriteBatches, this);
+    return true;
+}
+
+void InputRecorder::RecordConnect(int id, const JoystickDescriptor& descriptor, const std::string& stableKey,
+    const char *path, const JoystickState& state)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (!this->file)
+        return;
+
+    int slot;
+    auto it = this->slots.find(id);
+    if (it != this->slots.end() && this->devices[it->second].descriptor == descriptor
+        && this->stableKeys[it->second] == stableKey)
+    {
+        slot = it->second;
+        if (this->connected[slot])
+            return;
+    }
+    else
+    {
+        // a new device, or a full device table handed a retired ID to another one
+        if (this->devices.size() >= MAX_DEVICES)
+            return;
+
+        RecordedDevice device;
+        memset(&device, 0, sizeof(RecordedDevice));
+        device.descriptor = descriptor;
+        strncpy(device.path, path, sizeof(device.path) - 1);
+        device.initial = state;
+
+        slot = static_cast<int>(this->devices.size());
+        this->devices.push_back(device);
+        this->stableKeys.push_back(stableKey);
+        this->connected.push_back(false);
+        this->slots[id] = slot;
+    }
+    this->connected[slot] = true;
+
+    // the connect record is followed by the state the device came up with
+    uint64_t now = MonotonicNanoseconds();
+    RecordedEvent record = { now, 0, 0, RECORD_CONNECT, static_cast<uint8_t>(slot) };
+    this->Append(record);
+
+    for (int code = 0; code < ABS_CNT; code++)
+    {
+        if (state.HasAxis(code))
+            this->Append({ now, state.GetAxis(code), static_cast<uint16_t>(code), EV_ABS, static_cast<uint8_t>(slot) });
+    }
+    for (int code = 0; code < KEY_CNT; code++)
+    {
+        if (state.HasButton(code))
+            this->Append({ now, state.GetButton(code), static_cast<uint16_t>(code), EV_KEY, static_cast<uint8_t>(slot) });
+    }
+    this->Append({ now, 0, SYN_REPORT, EV_SYN, static_cast<uint8_t>(slot) });
+}
+
+void InputRecorder::RecordDisconnect(int id)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto it = this->slots.find(id);
+    if (!this->file || it == this->slots.end() || !this->connected[it->second])
+        return;
+
+    this->connected[it->second] = false;
+    this->Append({ MonotonicNanoseconds(), 0, 0, RECORD_DISCONNECT, static_cast<uint8_t>(it->second) });
+}
+
+void InputRecorder::RecordEvent(int id, const struct input_event& ev)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto it = this->slots.find(id);
+    if (!this->file || it == this->slots.end() || !this->connected[it->second])
+        return;
+
+    this->Append({ ToNanoseconds(ev.time), ev.value, ev.code, static_cast<uint8_t>(ev.type),
+        static_cast<uint8_t>(it->second) });
+}
+
+bool InputRecorder::Close()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+    if (!this->file || this->closing)
+        return false;
+
+    // the writer finishes its batch and exits; the rest is written here, a
+    // batch the reader handed over meanwhile first
+    this->closing = true;
+    this->writerCondition.notify_all();
+    guard.unlock();
+    if (this->writer.joinable())
+        this->writer.join();
+    guard.lock();
+
+    if (!this->writing.empty()
+        && fwrite(this->writing.data(), sizeof(RecordedEvent), this->writing.size(), this->file) != this->writing.size())
+        this->failed = true;
+    if (!this->buffer.empty()
+        && fwrite(this->buffer.data(), sizeof(RecordedEvent), this->buffer.size(), this->file) != this->buffer.size())
+        this->failed = true;
+    this->writing.clear();
+    this->buffer.clear();
+
+    RecordingTrailer trailer;
+    memset(&trailer, 0, sizeof(RecordingTrailer));
+    trailer.recordCount = this->recordCount;
+    trailer.deviceCount = static_cast<uint32_t>(this->devices.size());
+    trailer.indexCount = static_cast<uint32_t>(this->index.size());
+    trailer.deviceOffset = sizeof(RecordingHeader) + this->recordCount * sizeof(RecordedEvent);
+    trailer.indexOffset = trailer.deviceOffset + this->devices.size() * sizeof(RecordedDevice);
+    memcpy(trailer.magic, RECORDING_END_MAGIC, sizeof(trailer.magic));
+
+    if (!this->devices.empty()
+        && fwrite(this->devices.data(), sizeof(RecordedDevice), this->devices.size(), this->file) != this->devices.size())
+        this->failed = true;
+    if (!this->index.empty()
+        && fwrite(this->index.data(), sizeof(RecordingIndex), this->index.size(), this->file) != this->index.size())
+        this->failed = true;
+    if (fwrite(&trailer, sizeof(RecordingTrailer), 1, this->file) != 1)
+        this->failed = true;
+    if (fclose(this->file) != 0)
+        this->failed = true;
+
+    this->file = nullptr;
+    return !this->failed;
+}
+
+void InputRecorder::Append(const RecordedEvent& record)
+{
+    if (this->recordCount % INDEX_STRIDE == 0)
+        this->index.push_back({ record.time, this->recordCount });
+
+    this->buffer.push_back(record);
+    this->recordCount++;
+
+    // hand a full batch over if the writer is idle; if the disk is slow, keep
+    // buffering rather than make the reader thread wait for it
+    if (this->buffer.size() >= WRITE_BATCH && this->writing.empty())
+    {
+        this->writing.swap(this->buffer);
+        this->writerCondition.notify_one();
+    }
+}
+
+void InputRecorder::WriteBatches()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+    while (true)
+    {
+        this->writerCondition.wait(guard, [this]() { return !this->writing.empty() || this->closing; });
+        if (this->writing.empty())
+            break;
+
+        // the reader leaves `writing` alone until it is empty again
+        guard.unlock();
+        bool written = fwrite(this->writing.data(), sizeof(RecordedEvent), this->writing.size(), this->file)
+            == this->writing.size();
+        guard.lock();
+
+        if (!written)
+            this->failed = true;
+        this->writing.clear();
+    }
+}
@@ -0,0 +1,264 @@
+#include "InputRecording.hpp"
+#include <chrono>
+#include <sys/mman.h>
+
+using namespace JoystickLibrary;
+
+// in fast replay, the feeder waits once a device has this many unread events
+constexpr size_t MAX_QUEUED = 4096;
+// how long Play waits for the reader thread to make progress before giving up,
+// e.g. when the enumerator is not running
+constexpr int STALL_TIMEOUT_MS = 2000;
+// waits are cut into slices this long so Stop is noticed
+constexpr int STOP_CHECK_MS = 50;
+
+// waits on a device in slices until done, stopped or stalled
+template <typename Wait>
+static bool WaitForReader(const std::atomic<bool>& stopping, Wait wait)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(STALL_TIMEOUT_MS);
+    while (!stopping.load(std::memory_order_relaxed))
+    {
+        if (wait(STOP_CHECK_MS))
+            return true;
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+    }
+    return false;
+}
+
+
+InputReplayer::InputReplayer()
+{
+    mapping = nullptr;
+    mappingSize = 0;
+    records = nullptr;
+    recordCount = 0;
+    devices = nullptr;
+    deviceCount = 0;
+    index = nullptr;
+    indexCount = 0;
+    backend = nullptr;
+    stopping.store(false);
+}
+
+InputReplayer::~InputReplayer()
+{
+    this->Unmap();
+}
+
+bool InputReplayer::Open(const char *path)
+{
+    this->Unmap();
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(RecordingHeader) + sizeof(RecordingTrailer))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    this->mapping = map;
+    this->mappingSize = size;
+
+    // validate everything up front so Play can trust the offsets
+    const char *base = static_cast<const char *>(map);
+    const RecordingHeader *header = reinterpret_cast<const RecordingHeader *>(base);
+    const RecordingTrailer *trailer = reinterpret_cast<const RecordingTrailer *>(base + size - sizeof(RecordingTrailer));
+
+    if (memcmp(header->magic, RECORDING_MAGIC, sizeof(header->magic)) != 0
+        || memcmp(trailer->magic, RECORDING_END_MAGIC, sizeof(trailer->magic)) != 0
+        || header->recordSize != sizeof(RecordedEvent)
+        || header->deviceSize != sizeof(RecordedDevice)
+        || trailer->deviceCount > InputRecorder::MAX_DEVICES)
+    {
+        this->Unmap();
+        return false;
+    }
+
+    // bound every count by the bytes between header and trailer, so the offsets below cannot wrap
+    uint64_t body = size - sizeof(RecordingHeader) - sizeof(RecordingTrailer);
+    if (trailer->recordCount > body / sizeof(RecordedEvent)
+        || trailer->deviceCount > body / sizeof(RecordedDevice)
+        || trailer->indexCount > body / sizeof(RecordingIndex))
+    {
+        this->Unmap();
+        return false;
+    }
+
+    uint64_t deviceOffset = sizeof(RecordingHeader) + trailer->recordCount * sizeof(RecordedEvent);
+    uint64_t indexOffset = deviceOffset + uint64_t(trailer->deviceCount) * sizeof(RecordedDevice);
+    uint64_t trailerOffset = indexOffset + uint64_t(trailer->indexCount) * sizeof(RecordingIndex);
+    if (trailer->deviceOffset != deviceOffset || trailer->indexOffset != indexOffset
+        || trailerOffset + sizeof(RecordingTrailer) != size)
+    {
+        this->Unmap();
+        return false;
+    }
+
+    // Play builds strings from the paths
+    const RecordedDevice *recordedDevices = reinterpret_cast<const RecordedDevice *>(base + deviceOffset);
+    for (uint32_t i = 0; i < trailer->deviceCount; i++)
+    {
+        if (!memchr(recordedDevices[i].path, 0, sizeof(recordedDevices[i].path)))
+        {
+            this->Unmap();
+            return false;
+        }
+    }
+
+    this->records = reinterpret_cast<const RecordedEvent *>(base + sizeof(RecordingHeader));
+    this->recordCount = trailer->recordCount;
+    this->devices = recordedDevices;
+    this->deviceCount = static_cast<int>(trailer->deviceCount);
+    this->index = reinterpret_cast<const RecordingIndex *>(base + indexOffset);
+    this->indexCount = trailer->indexCount;
+
+    // records are read front to back exactly once
+    madvise(map, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+std::unique_ptr<InputBackend> InputReplayer::CreateBackend()
+{
+    this->backend = new SyntheticBackend();
+    return std::unique_ptr<InputBackend>(this->backend);
+}
+
+bool InputReplayer::Play(ReplaySpeed speed)
+{
+    if (!this->mapping || !this->backend)
+        return false;
+
+    this->stopping.store(false);
+    std::vector<std::shared_ptr<SyntheticDevice>> plugged(this->deviceCount);
+    bool stalled = false;
+
+    uint64_t firstTime = this->recordCount ? this->records[0].time : 0;
+    uint64_t startTime = MonotonicNanoseconds();
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < this->recordCount && !stalled; i++)
+    {
+        if (this->stopping.load(std::memory_order_relaxed))
+            break;
+
+        const RecordedEvent& record = this->records[i];
+        if (record.device >= this->deviceCount)
+            continue;
+
+        uint64_t offset = record.time > firstTime ? record.time - firstTime : 0;
+        if (speed == ReplaySpeed::REAL_TIME)
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(offset));
+
+        std::shared_ptr<SyntheticDevice>& device = plugged[record.device];
+        const RecordedDevice& recorded = this->devices[record.device];
+
+        if (record.type == RECORD_CONNECT)
+        {
+            if (!device)
+                device = this->backend->Plug(recorded.path, recorded.descriptor, recorded.initial);
+        }
+        else if (record.type == RECORD_DISCONNECT)
+        {
+            if (device)
+            {
+                // a replug of the same path must not race the old connection
+                this->backend->Unplug(recorded.path);
+                stalled = !WaitForReader(this->stopping, [&](int timeoutMs) { return device->WaitReleased(timeoutMs); });
+            }
+            device.reset();
+        }
+        else if (device)
+        {
+            if (speed == ReplaySpeed::REAL_TIME)
+                device->Emit(record.type, record.code, record.value, startTime + offset);
+            else
+            {
+                // keep the queue bounded when the reader falls behind
+                if (device->GetQueued() >= MAX_QUEUED)
+                {
+                    stalled = !WaitForReader(this->stopping, [&](int timeoutMs) {
+                        return device->WaitQueued(MAX_QUEUED - 1, timeoutMs);
+                    });
+                    if (stalled)
+                        break;
+                }
+                device->Emit(record.type, record.code, record.value);
+            }
+        }
+    }
+
+    // let the reader thread catch up before reporting the replay done
+    for (auto& device : plugged)
+    {
+        if (device && !stalled)
+            stalled = !WaitForReader(this->stopping, [&](int timeoutMs) { return device->WaitQueued(0, timeoutMs); });
+    }
+
+    return !stalled && !this->stopping.load();
+}
+
+void InputReplayer::Stop()
+{
+    this->stopping.store(true);
+}
+
+uint64_t InputReplayer::GetDuration() const
+{
+    if (this->recordCount == 0)
+        return 0;
+
+    uint64_t first = this->records[0].time;
+    uint64_t last = this->records[this->recordCount - 1].time;
+    return last > first ? last - first : 0;
+}
+
+uint64_t InputReplayer::FindRecord(uint64_t time) const
+{
+    if (this->recordCount == 0)
+        return 0;
+
+    uint64_t target = this->records[0].time + time;
+
+    // last index entry at or before the target, then scan forward
+    uint32_t low = 0, high = this->indexCount;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (this->index[middle].time <= target)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    uint64_t record = low > 0 ? this->index[low - 1].record : 0;
+    while (record < this->recordCount && this->records[record].time < target)
+        record++;
+    return record;
+}
+
+void InputReplayer::Unmap()
+{
+    if (this->mapping)
+        munmap(this->mapping, this->mappingSize);
+
+    this->mapping = nullptr;
+    this->mappingSize = 0;
+    this->records = nullptr;
+    this->recordCount = 0;
+    this->devices = nullptr;
+    this->deviceCount = 0;
+    this->index = nullptr;
+    this->indexCount = 0;
+}
@@ -0,0 +1,161 @@
+#include "Types.hpp"
+#include <cmath>
+
+using namespace JoystickLibrary;
+
+// used when neither the shaping nor the device gives a range
+constexpr int DEFAULT_MINIMUM = -32768;
+constexpr int DEFAULT_MAXIMUM = 32767;
+// longest step a filter takes at once, so a long idle gap does not jump
+constexpr float MAX_STEP = 0.1f;
+constexpr float PI = 3.14159265f;
+
+struct AxisFrame
+{
+    float center;
+    float half;
+};
+
+static AxisFrame FrameOf(const AxisShaping& shaping, const AxisRange& reported)
+{
+    int minimum = DEFAULT_MINIMUM, maximum = DEFAULT_MAXIMUM;
+    if (shaping.rangeMinimum != shaping.rangeMaximum)
+    {
+        minimum = std::min(shaping.rangeMinimum, shaping.rangeMaximum);
+        maximum = std::max(shaping.rangeMinimum, shaping.rangeMaximum);
+    }
+    else if (reported.minimum != reported.maximum)
+    {
+        minimum = reported.minimum;
+        maximum = reported.maximum;
+    }
+
+    AxisFrame frame;
+    frame.center = (float(minimum) + float(maximum)) * 0.5f;
+    frame.half = (float(maximum) - float(minimum)) * 0.5f;
+    return frame;
+}
+
+static float Normalize(const AxisFrame& frame, int raw)
+{
+    float x = (float(raw) - frame.center) / frame.half;
+    return std::min(1.0f, std::max(-1.0f, x));
+}
+
+// maps deadzone..(1 - outerDeadzone) onto 0..1
+static float Rescale(const AxisShaping& shaping, float magnitude)
+{
+    if (magnitude <= shaping.deadzone)
+        return 0.0f;
+
+    float live = 1.0f - shaping.deadzone - shaping.outerDeadzone;
+    if (live <= 0.0f)
+        return 1.0f;
+    return std::min(1.0f, (magnitude - shaping.deadzone) / live);
+}
+
+// alpha of a one-pole low-pass at cutoff Hz over dt seconds
+static float LowPassAlpha(float cutoff, float dt)
+{
+    float tau = 1.0f / (2.0f * PI * std::max(cutoff, 1e-3f));
+    return 1.0f / (1.0f + tau / dt);
+}
+
+
+InputShaper::InputShaper()
+{
+    this->version = 0;
+    this->Reset();
+}
+
+void InputShaper::Reset()
+{
+    this->lastTime = 0;
+    for (auto& filter : this->filters)
+        filter = { 0.0f, 0.0f, 0.0f, false };
+}
+
+bool InputShaper::Update(const ShapingTable& table, const AxisRange *ranges, const JoystickState& raw, uint64_t now,
+    JoystickState& shaped)
+{
+    if (table.version != this->version)
+    {
+        this->version = table.version;
+        this->Reset();
+    }
+
+    float dt = this->lastTime ? std::min(MAX_STEP, float(now - this->lastTime) * 1e-9f) : 0.0f;
+    this->lastTime = now;
+
+    bool settling = false;
+    for (uint64_t mask = table.mask; mask; mask &= mask - 1)
+    {
+        int code = __builtin_ctzll(mask);
+        const AxisShaping& shaping = table.axes[code];
+        Filter& filter = this->filters[code];
+
+        AxisFrame frame = FrameOf(shaping, ranges[code]);
+        if (frame.half <= 0.0f || !raw.HasAxis(code))
+            continue;
+
+        // deadzones: axial on the axis alone, radial on the stick vector
+        float x = Normalize(frame, raw.GetAxis(code));
+        int other = shaping.radialCode;
+        if (other >= 0 && other < ABS_CNT && other != code && raw.HasAxis(other))
+        {
+            const AxisShaping& otherShaping = (table.mask >> other) & 1 ? table.axes[other] : shaping;
+            float y = Normalize(FrameOf(otherShaping, ranges[other]), raw.GetAxis(other));
+            float magnitude = std::sqrt(x * x + y * y);
+            x = magnitude > 0.0f ? x / magnitude * Rescale(shaping, magnitude) : 0.0f;
+        }
+        else
+            x = std::copysign(Rescale(shaping, std::fabs(x)), x);
+
+        x = (1.0f - shaping.expo) * x + shaping.expo * x * x * x;
+
+        if (!filter.primed || dt <= 0.0f)
+        {
+            if (!filter.primed)
+            {
+                filter.value = x;
+                filter.input = x;
+                filter.speed = 0.0f;
+                filter.primed = true;
+            }
+        }
+        else
+        {
+            float target = x;
+            if (shaping.smoothing == Smoothing::EMA)
+            {
+                float alpha = 1.0f - std::exp(-dt / std::max(shaping.emaTime, 1e-4f));
+                target = filter.value + alpha * (x - filter.value);
+            }
+            else if (shaping.smoothing == Smoothing::ONE_EURO)
+            {
+                float speed = (x - filter.input) / dt;
+                filter.speed += LowPassAlpha(shaping.derivativeCutoff, dt) * (speed - filter.speed);
+                float cutoff = shaping.minCutoff + shaping.beta * std::fabs(filter.speed);
+                target = filter.value + LowPassAlpha(cutoff, dt) * (x - filter.value);
+            }
+            filter.input = x;
+
+            if (shaping.slewRate > 0.0f)
+            {
+                float step = shaping.slewRate * dt;
+                target = std::min(filter.value + step, std::max(filter.value - step, target));
+            }
+            filter.value = target;
+        }
+
+        // snap once within half a raw unit, so a still input stops needing updates
+        if (std::fabs(filter.value - x) * frame.half < 0.5f)
+            filter.value = x;
+        else
+            settling = true;
+
+        shaped.axes[code] = static_cast<int>(std::lround(frame.center + filter.value * frame.half));
+    }
+
+    return settling;
+}
@@ -0,0 +1,186 @@
+#include "JoystickSampler.hpp"
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+
+using namespace JoystickLibrary;
+
+constexpr int MAX_RATE_HZ = 10000;
+
+
+JoystickSampler::JoystickSampler()
+{
+    period = 0;
+    firstDeadline = 0;
+    timer_fd = -1;
+    stop_fd = -1;
+    samples.store(0);
+    missed.store(0);
+    torn.store(0);
+}
+
+JoystickSampler::~JoystickSampler()
+{
+    Stop();
+}
+
+bool JoystickSampler::Start(const SamplerOptions& options, SampleCallback callback)
+{
+    if (this->thread.joinable() || !callback || options.rateHz <= 0 || options.rateHz > MAX_RATE_HZ)
+        return false;
+
+    this->selected.assign(DeviceTable::CAPACITY, false);
+    for (int id : options.joystickIDs)
+    {
+        if (id < 0 || id >= DeviceTable::CAPACITY)
+            return false;
+        this->selected[id] = true;
+    }
+
+    this->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    this->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (this->timer_fd < 0 || this->stop_fd < 0)
+    {
+        this->Stop();
+        return false;
+    }
+
+    this->options = options;
+    this->callback = callback;
+    this->period = 1000000000ull / options.rateHz;
+    this->frame.resize(DeviceTable::CAPACITY);
+
+    // absolute deadlines: the kernel keeps the phase, however late the thread wakes up
+    this->firstDeadline = MonotonicNanoseconds() + this->period;
+    struct itimerspec spec;
+    spec.it_value.tv_sec = this->firstDeadline / 1000000000ull;
+    spec.it_value.tv_nsec = this->firstDeadline % 1000000000ull;
+    spec.it_interval.tv_sec = this->period / 1000000000ull;
+    spec.it_interval.tv_nsec = this->period % 1000000000ull;
+    if (timerfd_settime(this->timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0)
+    {
+        this->Stop();
+        return false;
+    }
+
+    this->thread = std::thread(&JoystickSampler::Run, this);
+    return true;
+}
+
+void JoystickSampler::Stop()
+{
+    if (this->thread.joinable())
+    {
+        uint64_t one = 1;
+        write(this->stop_fd, &one, sizeof(uint64_t));
+        this->thread.join();
+    }
+    if (this->timer_fd >= 0)
+        close(this->timer_fd);
+    if (this->stop_fd >= 0)
+        close(this->stop_fd);
+    this->timer_fd = -1;
+    this->stop_fd = -1;
+}
+
+bool JoystickSampler::IsRunning() const
+{
+    return this->thread.joinable();
+}
+
+SamplerStats JoystickSampler::GetStats() const
+{
+    SamplerStats stats;
+    stats.samples = this->samples.load(std::memory_order_relaxed);
+    stats.missed = this->missed.load(std::memory_order_relaxed);
+    stats.torn = this->torn.load(std::memory_order_relaxed);
+    stats.lateness = this->lateness.GetStats();
+    stats.periodJitter = this->periodJitter.GetStats();
+    return stats;
+}
+
+void JoystickSampler::ResetStats()
+{
+    this->samples.store(0, std::memory_order_relaxed);
+    this->missed.store(0, std::memory_order_relaxed);
+    this->torn.store(0, std::memory_order_relaxed);
+    this->lateness.Reset();
+    this->periodJitter.Reset();
+}
+
+void JoystickSampler::Run()
+{
+    // the default 50 us of timer slack would all show up as jitter
+    prctl(PR_SET_TIMERSLACK, 1, 0, 0, 0);
+
+    Enumerator& enumerator = Enumerator::GetInstance();
+    struct pollfd fds[2];
+    fds[0].fd = this->timer_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = this->stop_fd;
+    fds[1].events = POLLIN;
+
+    uint64_t tick = 0;
+    uint64_t lastCapture = 0;
+    while (true)
+    {
+        int ret = poll(fds, 2, -1);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (fds[1].revents)
+            return;
+
+        // more than one expiration means deadlines passed while we were busy
+        uint64_t expirations = 0;
+        if (read(this->timer_fd, &expirations, sizeof(uint64_t)) != sizeof(uint64_t) || expirations == 0)
+            continue;
+        tick += expirations;
+
+        SampleFrame sample;
+        sample.tick = tick;
+        sample.deadline = this->firstDeadline + (tick - 1) * this->period;
+        sample.missed = expirations - 1;
+        sample.count = enumerator.GetAllSnapshots(this->frame.data(), static_cast<int>(this->frame.size()),
+            sample.captureTime, sample.coherent);
+        sample.count = this->Select(this->frame.data(), sample.count);
+        sample.snapshots = this->frame.data();
+
+        this->lateness.Record(sample.captureTime > sample.deadline ? sample.captureTime - sample.deadline : 0);
+        if (lastCapture)
+        {
+            uint64_t actual = sample.captureTime - lastCapture;
+            uint64_t nominal = expirations * this->period;
+            this->periodJitter.Record(actual > nominal ? actual - nominal : nominal - actual);
+        }
+        lastCapture = sample.captureTime;
+
+        this->missed.fetch_add(sample.missed, std::memory_order_relaxed);
+        if (!sample.coherent)
+            this->torn.fetch_add(1, std::memory_order_relaxed);
+        this->callback(sample);
+        this->samples.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int JoystickSampler::Select(DeviceSnapshot *snapshots, int count) const
+{
+    if (this->options.joystickIDs.empty())
+        return count;
+
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (!this->selected[snapshots[i].id])
+            continue;
+        if (kept != i)
+            snapshots[kept] = snapshots[i];
+        kept++;
+    }
+    return kept;
+}
@@ -0,0 +1,214 @@
+#include "PipeBackend.hpp"
+#include <cerrno>
+
+namespace JoystickLibrary
+{
+    class PipeInputDevice : public InputDevice
+    {
+    public:
+        explicit PipeInputDevice(const std::shared_ptr<PipeBackend::Stream>& stream)
+            : stream(stream), start(0), end(0), partial(0), resyncing(false), taken(false)
+        {
+        }
+
+        int GetFd() const override
+        {
+            return stream->fd;
+        }
+
+        JoystickDescriptor GetDescriptor() const override
+        {
+            return stream->descriptor;
+        }
+
+        void Seed(JoystickState& state) override
+        {
+            state = stream->initial;
+        }
+
+        ReadStatus Next(struct input_event& ev, bool sync) override
+        {
+            if (stream->detached.load(std::memory_order_acquire))
+                return ReadStatus::FAILED;
+
+            if (sync && !resyncing)
+                return ReadStatus::AGAIN;
+
+            if (start == end)
+            {
+                ReadStatus status = Fill();
+                if (status != ReadStatus::SUCCESS)
+                    return status;
+            }
+
+            ev = buffer[start++];
+
+            if (sync)
+            {
+                // the delta ends with the SYN_REPORT that closes it
+                if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+                {
+                    resyncing = false;
+                    return ReadStatus::AGAIN;
+                }
+                return ReadStatus::SYNC;
+            }
+
+            if (ev.type == EV_SYN && ev.code == SYN_DROPPED)
+            {
+                resyncing = true;
+                return ReadStatus::SYNC;
+            }
+            return ReadStatus::SUCCESS;
+        }
+
+        int TakeReads() override
+        {
+            taken = true;
+            return stream->fd;
+        }
+
+        void Deliver(const void *data, size_t size) override
+        {
+            char *bytes = this->compact();
+            memcpy(bytes + partial, data, size);
+            this->frame(partial + size);
+        }
+
+    private:
+        static const int BUFFER_EVENTS = 64;
+
+        // keeps a torn record's leading bytes at the front of the buffer
+        char *compact()
+        {
+            char *bytes = reinterpret_cast<char *>(buffer);
+            if (partial > 0)
+                memmove(bytes, bytes + end * sizeof(struct input_event), partial);
+            return bytes;
+        }
+
+        void frame(size_t total)
+        {
+            start = 0;
+            end = static_cast<int>(total / sizeof(struct input_event));
+            partial = total % sizeof(struct input_event);
+        }
+
+        ReadStatus Fill()
+        {
+            // the fd belongs to whoever took the reads; they Deliver what it returns
+            if (taken)
+                return ReadStatus::AGAIN;
+
+            char *bytes = this->compact();
+
+            ssize_t rc = read(stream->fd, bytes + partial, sizeof(buffer) - partial);
+            if (rc == 0)
+                return ReadStatus::FAILED;
+            if (rc < 0)
+                return (errno == EAGAIN || errno == EINTR) ? ReadStatus::AGAIN : ReadStatus::FAILED;
+
+            this->frame(partial + static_cast<size_t>(rc));
+            return end > 0 ? ReadStatus::SUCCESS : ReadStatus::AGAIN;
+        }
+
+        std::shared_ptr<PipeBackend::Stream> stream;
+        // one extra record for a torn record plus a full delivery
+        struct input_event buffer[BUFFER_EVENTS + 1];
+        int start;
+        int end;
+        size_t partial;
+        bool resyncing;
+        bool taken;
+    };
+}
+
+using namespace JoystickLibrary;
+
+
+PipeBackend::Stream::~Stream()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+PipeBackend::PipeBackend()
+{
+}
+
+PipeBackend::~PipeBackend()
+{
+}
+
+bool PipeBackend::Attach(const std::string& path, JoystickDescriptor descriptor, int fd, const JoystickState& initial)
+{
+    if (fd < 0)
+        return false;
+
+    std::shared_ptr<Stream> stream = std::make_shared<Stream>();
+    stream->descriptor = descriptor;
+    stream->initial = initial;
+    stream->fd = fd;
+    stream->detached.store(false);
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->attached.count(path))
+        {
+            // leave the caller's fd alone
+            stream->fd = -1;
+            return false;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        this->attached[path] = stream;
+    }
+
+    this->hotplug.Post(HotplugEvent::Action::ADDED, path);
+    return true;
+}
+
+bool PipeBackend::Detach(const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        auto it = this->attached.find(path);
+        if (it == this->attached.end())
+            return false;
+        it->second->detached.store(true, std::memory_order_release);
+        this->attached.erase(it);
+    }
+
+    this->hotplug.Post(HotplugEvent::Action::REMOVED, path);
+    return true;
+}
+
+bool PipeBackend::Start()
+{
+    return this->hotplug.GetFd() >= 0;
+}
+
+int PipeBackend::GetFd() const
+{
+    return this->hotplug.GetFd();
+}
+
+void PipeBackend::Scan(std::vector<std::string>& paths)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    for (const auto& entry : this->attached)
+        paths.push_back(entry.first);
+}
+
+void PipeBackend::Receive(std::vector<HotplugEvent>& events)
+{
+    this->hotplug.Receive(events);
+}
+
+std::unique_ptr<InputDevice> PipeBackend::Open(const char *path)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto it = this->attached.find(path);
+    if (it == this->attached.end())
+        return nullptr;
+
+    return std::unique_ptr<InputDevice>(new PipeInputDevice(it->second));
+}
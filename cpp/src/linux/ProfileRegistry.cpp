@@ -0,0 +1,271 @@
+#include "ProfileRegistry.hpp"
+#include <fstream>
+#include <sstream>
+
+using namespace JoystickLibrary;
+
+struct AxisName
+{
+    const char *name;
+    ControllerAxis axis;
+};
+
+struct ButtonName
+{
+    const char *name;
+    ControllerButton button;
+};
+
+static const AxisName AXIS_NAMES[] = {
+    { "leftx", ControllerAxis::LeftX },
+    { "lefty", ControllerAxis::LeftY },
+    { "rightx", ControllerAxis::RightX },
+    { "righty", ControllerAxis::RightY },
+    { "lefttrigger", ControllerAxis::LeftTrigger },
+    { "righttrigger", ControllerAxis::RightTrigger },
+};
+
+static const ButtonName BUTTON_NAMES[] = {
+    { "a", ControllerButton::A },
+    { "b", ControllerButton::B },
+    { "x", ControllerButton::X },
+    { "y", ControllerButton::Y },
+    { "back", ControllerButton::Back },
+    { "guide", ControllerButton::Guide },
+    { "start", ControllerButton::Start },
+    { "leftstick", ControllerButton::LeftStick },
+    { "rightstick", ControllerButton::RightStick },
+    { "leftshoulder", ControllerButton::LeftShoulder },
+    { "rightshoulder", ControllerButton::RightShoulder },
+    { "dpup", ControllerButton::DpadUp },
+    { "dpdown", ControllerButton::DpadDown },
+    { "dpleft", ControllerButton::DpadLeft },
+    { "dpright", ControllerButton::DpadRight },
+};
+
+static_assert(sizeof(AXIS_NAMES) / sizeof(AXIS_NAMES[0]) == CONTROLLER_AXIS_COUNT, "every axis needs a name");
+static_assert(sizeof(BUTTON_NAMES) / sizeof(BUTTON_NAMES[0]) == CONTROLLER_BUTTON_COUNT, "every button needs a name");
+
+static int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool ParseGUID(const std::string& guid, JoystickDescriptor& descriptor)
+{
+    if (guid.size() != 32)
+        return false;
+
+    // eight little-endian words: bus, crc, vendor, 0, product, 0, version, driver
+    uint16_t words[8];
+    for (int i = 0; i < 8; i++)
+    {
+        int digits[4];
+        for (int j = 0; j < 4; j++)
+        {
+            digits[j] = HexDigit(guid[i * 4 + j]);
+            if (digits[j] < 0)
+                return false;
+        }
+        words[i] = static_cast<uint16_t>((digits[2] << 12) | (digits[3] << 8) | (digits[0] << 4) | digits[1]);
+    }
+
+    // anything else is a hash of the device name, which evdev cannot match
+    if (words[2] == 0 || words[3] != 0 || words[5] != 0)
+        return false;
+
+    descriptor = { words[2], words[4] };
+    return true;
+}
+
+static bool ParseNumber(const std::string& text, size_t& pos, int limit, int& value)
+{
+    size_t start = pos;
+    value = 0;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9')
+    {
+        value = value * 10 + (text[pos] - '0');
+        if (value > limit)
+            return false;
+        pos++;
+    }
+    return pos > start;
+}
+
+static bool ParseSource(const std::string& text, MappingSource& source)
+{
+    MappingSource parsed = { MappingSource::Kind::NONE, 0, 0, false, 0 };
+    size_t pos = 0;
+
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+        parsed.half = (text[pos++] == '+') ? 1 : -1;
+    if (pos >= text.size())
+        return false;
+
+    char kind = text[pos++];
+    int index;
+    if (!ParseNumber(text, pos, 255, index))
+        return false;
+    parsed.index = static_cast<uint8_t>(index);
+
+    if (kind == 'b' && !parsed.half)
+        parsed.kind = MappingSource::Kind::BUTTON;
+    else if (kind == 'a')
+    {
+        parsed.kind = MappingSource::Kind::AXIS;
+        if (pos < text.size() && text[pos] == '~')
+        {
+            parsed.invert = true;
+            pos++;
+        }
+    }
+    else if (kind == 'h' && !parsed.half)
+    {
+        int mask;
+        if (pos >= text.size() || text[pos++] != '.' || !ParseNumber(text, pos, 8, mask))
+            return false;
+        if (mask != 1 && mask != 2 && mask != 4 && mask != 8)
+            return false;
+        parsed.kind = MappingSource::Kind::HAT;
+        parsed.hatMask = static_cast<uint8_t>(mask);
+    }
+    else
+        return false;
+
+    if (pos != text.size())
+        return false;
+
+    source = parsed;
+    return true;
+}
+
+
+ProfileRegistry::ProfileRegistry()
+{
+}
+
+bool ProfileRegistry::Parse(const std::string& mapping, ControllerProfile& profile)
+{
+    std::vector<std::string> fields;
+    std::stringstream stream(mapping);
+    std::string field;
+    while (std::getline(stream, field, ','))
+        fields.push_back(field);
+
+    if (fields.size() < 2 || !ParseGUID(fields[0], profile.descriptor))
+        return false;
+
+    profile.name = fields[1];
+    for (auto& source : profile.axes)
+        source = { MappingSource::Kind::NONE, 0, 0, false, 0 };
+    for (auto& source : profile.buttons)
+        source = { MappingSource::Kind::NONE, 0, 0, false, 0 };
+
+    for (size_t i = 2; i < fields.size(); i++)
+    {
+        size_t colon = fields[i].find(':');
+        if (colon == std::string::npos)
+            continue;
+
+        std::string key = fields[i].substr(0, colon);
+        std::string value = fields[i].substr(colon + 1);
+
+        if (key == "platform")
+        {
+            if (value != "Linux")
+                return false;
+            continue;
+        }
+
+        MappingSource *target = nullptr;
+        for (auto& axis : AXIS_NAMES)
+        {
+            if (key == axis.name)
+                target = &profile.axes[static_cast<int>(axis.axis)];
+        }
+        for (auto& button : BUTTON_NAMES)
+        {
+            if (key == button.name)
+                target = &profile.buttons[static_cast<int>(button.button)];
+        }
+
+        // half-axis outputs, paddles, hints and the like have nowhere to go
+        if (!target)
+            continue;
+        if (!ParseSource(value, *target))
+            return false;
+    }
+
+    return true;
+}
+
+bool ProfileRegistry::AddMapping(const std::string& mapping, std::vector<JoystickDescriptor>& added)
+{
+    std::shared_ptr<ControllerProfile> profile = std::make_shared<ControllerProfile>();
+    if (!Parse(mapping, *profile))
+        return false;
+
+    std::lock_guard<std::mutex> guard(this->lock);
+    std::shared_ptr<const ControllerProfile>& slot = this->profiles[DescriptorKey(profile->descriptor)];
+    if (!slot)
+        added.push_back(profile->descriptor);
+    slot = profile;
+    return true;
+}
+
+int ProfileRegistry::AddMappings(const std::string& mappings, std::vector<JoystickDescriptor>& added)
+{
+    int count = 0;
+    std::stringstream stream(mappings);
+    std::string line;
+
+    while (std::getline(stream, line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        size_t end = line.find_last_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        if (this->AddMapping(line.substr(start, end - start + 1), added))
+            count++;
+    }
+
+    return count;
+}
+
+int ProfileRegistry::AddMappingsFromFile(const char *path, std::vector<JoystickDescriptor>& added)
+{
+    std::ifstream file(path);
+    if (!file)
+        return -1;
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return this->AddMappings(contents.str(), added);
+}
+
+std::shared_ptr<const ControllerProfile> ProfileRegistry::Find(const JoystickDescriptor& descriptor) const
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto it = this->profiles.find(DescriptorKey(descriptor));
+    return it != this->profiles.end() ? it->second : nullptr;
+}
+
+int ProfileRegistry::GetCount() const
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    return static_cast<int>(this->profiles.size());
+}
+
+void ProfileRegistry::GetDescriptors(std::vector<JoystickDescriptor>& descriptors) const
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    for (auto& profile : this->profiles)
+        descriptors.push_back(profile.second->descriptor);
+}
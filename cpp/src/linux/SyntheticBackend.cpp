@@ -0,0 +1,313 @@
+#include "SyntheticBackend.hpp"
+#include <sys/eventfd.h>
+
+namespace JoystickLibrary
+{
+    class SyntheticInputDevice : public InputDevice
+    {
+    public:
+        explicit SyntheticInputDevice(const std::shared_ptr<SyntheticDevice>& device)
+            : device(device)
+        {
+        }
+
+        ~SyntheticInputDevice()
+        {
+            std::lock_guard<std::mutex> guard(device->lock);
+            device->openCount--;
+            device->Progress();
+        }
+
+        int GetFd() const override
+        {
+            return device->event_fd;
+        }
+
+        JoystickDescriptor GetDescriptor() const override
+        {
+            return device->descriptor;
+        }
+
+        void Seed(JoystickState& state) override
+        {
+            std::lock_guard<std::mutex> guard(device->lock);
+            state = device->delivered;
+        }
+
+        bool GetStableKey(std::string& key) const override
+        {
+            if (device->stableKey.empty())
+                return false;
+            key = device->stableKey;
+            return true;
+        }
+
+        ReadStatus Next(struct input_event& ev, bool sync) override
+        {
+            std::lock_guard<std::mutex> guard(device->lock);
+
+            if (device->failed || device->unplugged)
+                return ReadStatus::FAILED;
+
+            if (sync)
+            {
+                if (device->syncDelta.empty())
+                    return ReadStatus::AGAIN;
+                ev = device->syncDelta.front();
+                device->syncDelta.pop_front();
+                ApplyTo(device->delivered, ev);
+                device->Progress();
+                return ReadStatus::SYNC;
+            }
+
+            if (device->dropped)
+            {
+                device->dropped = false;
+                ev = MakeEvent(EV_SYN, SYN_DROPPED, 0, MonotonicNanoseconds());
+                return ReadStatus::SYNC;
+            }
+
+            if (device->queue.empty())
+            {
+                // reset the eventfd under the lock so a concurrent Emit re-arms it
+                uint64_t count;
+                read(device->event_fd, &count, sizeof(uint64_t));
+                return ReadStatus::AGAIN;
+            }
+
+            ev = device->queue.front();
+            device->queue.pop_front();
+            ApplyTo(device->delivered, ev);
+            device->Progress();
+            return ReadStatus::SUCCESS;
+        }
+
+        static struct input_event MakeEvent(uint16_t type, uint16_t code, int32_t value, uint64_t eventTime)
+        {
+            struct input_event ev;
+            memset(&ev, 0, sizeof(struct input_event));
+            ev.time.tv_sec = static_cast<time_t>(eventTime / 1000000000ull);
+            ev.time.tv_usec = static_cast<suseconds_t>((eventTime % 1000000000ull) / 1000ull);
+            ev.type = type;
+            ev.code = code;
+            ev.value = value;
+            return ev;
+        }
+
+        static void ApplyTo(JoystickState& state, const struct input_event& ev)
+        {
+            if (ev.type == EV_ABS)
+                state.SetAxis(ev.code, ev.value);
+            else if (ev.type == EV_KEY)
+                state.SetButton(ev.code, !!ev.value);
+        }
+
+    private:
+        std::shared_ptr<SyntheticDevice> device;
+    };
+}
+
+using namespace JoystickLibrary;
+
+
+SyntheticDevice::SyntheticDevice(const std::string& path, JoystickDescriptor descriptor, const JoystickState& initial,
+    const std::string& stableKey)
+    : path(path),
+      descriptor(descriptor),
+      stableKey(stableKey),
+      current(initial),
+      delivered(initial),
+      dropped(false),
+      failed(false),
+      unplugged(false),
+      openCount(0),
+      waiting(0)
+{
+    event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+SyntheticDevice::~SyntheticDevice()
+{
+    if (event_fd >= 0)
+        close(event_fd);
+}
+
+void SyntheticDevice::Emit(uint16_t type, uint16_t code, int32_t value, uint64_t eventTime)
+{
+    struct input_event ev = SyntheticInputDevice::MakeEvent(type, code, value,
+        eventTime ? eventTime : MonotonicNanoseconds());
+
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->queue.push_back(ev);
+    SyntheticInputDevice::ApplyTo(this->current, ev);
+    this->Wake();
+}
+
+void SyntheticDevice::Report(uint64_t eventTime)
+{
+    this->Emit(EV_SYN, SYN_REPORT, 0, eventTime);
+}
+
+void SyntheticDevice::DropEvents()
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->queue.clear();
+
+    // the delta is whatever the reader has not seen, closed by a SYN_REPORT
+    uint64_t now = MonotonicNanoseconds();
+    JoystickState target = this->current;
+    this->syncDelta.clear();
+
+    for (int code = 0; code < ABS_CNT; code++)
+    {
+        if (target.HasAxis(code) && target.GetAxis(code) != this->delivered.GetAxis(code))
+            this->syncDelta.push_back(SyntheticInputDevice::MakeEvent(EV_ABS, code, target.GetAxis(code), now));
+    }
+    for (int code = 0; code < KEY_CNT; code++)
+    {
+        if (target.HasButton(code) && target.GetButton(code) != this->delivered.GetButton(code))
+            this->syncDelta.push_back(SyntheticInputDevice::MakeEvent(EV_KEY, code, target.GetButton(code), now));
+    }
+    this->syncDelta.push_back(SyntheticInputDevice::MakeEvent(EV_SYN, SYN_REPORT, 0, now));
+
+    this->dropped = true;
+    this->Wake();
+    this->Progress();
+}
+
+void SyntheticDevice::FailReads()
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->failed = true;
+    this->Wake();
+}
+
+size_t SyntheticDevice::GetQueued()
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->queue.size() + this->syncDelta.size();
+}
+
+bool SyntheticDevice::IsReleased()
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->openCount == 0;
+}
+
+bool SyntheticDevice::WaitQueued(size_t count, int timeoutMs)
+{
+    return this->wait_until(timeoutMs, [this, count]() { return this->queue.size() + this->syncDelta.size() <= count; });
+}
+
+bool SyntheticDevice::WaitReleased(int timeoutMs)
+{
+    return this->wait_until(timeoutMs, [this]() { return this->openCount == 0; });
+}
+
+template <typename Done>
+bool SyntheticDevice::wait_until(int timeoutMs, Done done)
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->waiting++;
+    bool finished = true;
+    if (timeoutMs < 0)
+        this->progress.wait(guard, done);
+    else
+        finished = this->progress.wait_for(guard, std::chrono::milliseconds(timeoutMs), done);
+    this->waiting--;
+    return finished;
+}
+
+void SyntheticDevice::Wake()
+{
+    uint64_t one = 1;
+    write(this->event_fd, &one, sizeof(uint64_t));
+}
+
+// called under lock; the reader only pays for the notify while someone waits
+void SyntheticDevice::Progress()
+{
+    if (this->waiting)
+        this->progress.notify_all();
+}
+
+SyntheticBackend::SyntheticBackend()
+{
+}
+
+SyntheticBackend::~SyntheticBackend()
+{
+}
+
+std::shared_ptr<SyntheticDevice> SyntheticBackend::Plug(const std::string& path, JoystickDescriptor descriptor,
+    const JoystickState& initial, const std::string& stableKey)
+{
+    std::shared_ptr<SyntheticDevice> device(new SyntheticDevice(path, descriptor, initial, stableKey));
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->plugged.count(path))
+            return nullptr;
+        this->plugged[path] = device;
+    }
+
+    this->hotplug.Post(HotplugEvent::Action::ADDED, path);
+    return device;
+}
+
+bool SyntheticBackend::Unplug(const std::string& path)
+{
+    std::shared_ptr<SyntheticDevice> device;
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        auto it = this->plugged.find(path);
+        if (it == this->plugged.end())
+            return false;
+        device = it->second;
+        this->plugged.erase(it);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(device->lock);
+        device->unplugged = true;
+        device->Wake();
+    }
+
+    this->hotplug.Post(HotplugEvent::Action::REMOVED, path);
+    return true;
+}
+
+bool SyntheticBackend::Start()
+{
+    return this->hotplug.GetFd() >= 0;
+}
+
+int SyntheticBackend::GetFd() const
+{
+    return this->hotplug.GetFd();
+}
+
+void SyntheticBackend::Scan(std::vector<std::string>& paths)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    for (const auto& entry : this->plugged)
+        paths.push_back(entry.first);
+}
+
+void SyntheticBackend::Receive(std::vector<HotplugEvent>& events)
+{
+    this->hotplug.Receive(events);
+}
+
+std::unique_ptr<InputDevice> SyntheticBackend::Open(const char *path)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto it = this->plugged.find(path);
+    if (it == this->plugged.end() || it->second->event_fd < 0)
+        return nullptr;
+
+    {
+        std::lock_guard<std::mutex> deviceGuard(it->second->lock);
+        it->second->openCount++;
+    }
+    return std::unique_ptr<InputDevice>(new SyntheticInputDevice(it->second));
+}
@@ -0,0 +1,431 @@
+#include "InputBackend.hpp"
+#include <cerrno>
+#include <sys/ioctl.h>
+
+using namespace JoystickLibrary;
+
+constexpr const char *DEVICE_ADDED = "add";
+constexpr const char *DEVICE_REMOVED = "remove";
+
+namespace
+{
+    /**
+    * An evdev node. libevdev probes its capabilities and initial state;
+    * events are read in bulk straight from the fd, many records per read(),
+    * and decoded here rather than one libevdev_next_event call per event.
+    */
+    class EvdevDevice : public InputDevice
+    {
+    public:
+        EvdevDevice(int fd, struct libevdev *dev, const std::string& portPath)
+            : fd(fd), dev(dev), portPath(portPath), taken(false), start(0), end(0), deltaNext(0)
+        {
+        }
+
+        ~EvdevDevice()
+        {
+            libevdev_free(dev);
+            close(fd);
+        }
+
+        EvdevDevice(EvdevDevice const&) = delete;
+        void operator=(EvdevDevice const&) = delete;
+
+        int GetFd() const override
+        {
+            return fd;
+        }
+
+        JoystickDescriptor GetDescriptor() const override
+        {
+            return { libevdev_get_id_vendor(dev), libevdev_get_id_product(dev) };
+        }
+
+        void Seed(JoystickState& state) override
+        {
+            // take the current values up front so getters never fall back to the device
+            for (int code = 0; code < ABS_CNT; code++)
+            {
+                if (libevdev_has_event_code(dev, EV_ABS, code))
+                    state.SetAxis(code, libevdev_get_event_value(dev, EV_ABS, code));
+            }
+
+            for (int code = BTN_MISC; code < KEY_CNT; code++)
+            {
+                if (libevdev_has_event_code(dev, EV_KEY, code))
+                    state.SetButton(code, !!libevdev_get_event_value(dev, EV_KEY, code));
+            }
+
+            // what a resync compares the kernel's state against; libevdev never reads events
+            tracked = JoystickState();
+            for (int code = 0; code < ABS_CNT; code++)
+            {
+                if (state.HasAxis(code))
+                    tracked.SetAxis(code, state.GetAxis(code));
+            }
+            for (int code = BTN_MISC; code < KEY_CNT; code++)
+            {
+                if (state.HasButton(code))
+                    tracked.SetButton(code, state.GetButton(code));
+            }
+        }
+
+        bool GetAxisRange(int code, AxisRange& range) const override
+        {
+            const struct input_absinfo *info = libevdev_get_abs_info(dev, code);
+            if (!info)
+                return false;
+
+            range.minimum = info->minimum;
+            range.maximum = info->maximum;
+            return true;
+        }
+
+        bool GetStableKey(std::string& key) const override
+        {
+            // a serial number follows the device to any port; otherwise go by the port
+            const char *uniq = libevdev_get_uniq(dev);
+            if (uniq && uniq[0])
+                key = std::string("uniq:") + uniq;
+            else if (!portPath.empty())
+                key = "path:" + portPath;
+            else
+                return false;
+            return true;
+        }
+
+        ReadStatus Next(struct input_event& ev, bool sync) override
+        {
+            if (sync)
+                return this->next_delta(ev);
+
+            while (true)
+            {
+                ReadStatus status = this->next_buffered(ev);
+                if (status != ReadStatus::AGAIN || taken)
+                    return status;
+
+                status = this->fill();
+                if (status != ReadStatus::SUCCESS)
+                    return status;
+            }
+        }
+
+        int TakeReads() override
+        {
+            taken = true;
+            return fd;
+        }
+
+        void Deliver(const void *bytes, size_t size) override
+        {
+            // evdev only ever returns whole records
+            memcpy(buffer, bytes, size);
+            start = 0;
+            end = static_cast<int>(size / sizeof(struct input_event));
+        }
+
+    private:
+        ReadStatus fill()
+        {
+            ssize_t rc = read(fd, buffer, sizeof(buffer));
+            if (rc < 0)
+                return (errno == EAGAIN || errno == EINTR) ? ReadStatus::AGAIN : ReadStatus::FAILED;
+            if (rc == 0)
+                return ReadStatus::FAILED;
+
+            start = 0;
+            end = static_cast<int>(rc / sizeof(struct input_event));
+            return ReadStatus::SUCCESS;
+        }
+
+        ReadStatus next_buffered(struct input_event& ev)
+        {
+            while (start < end)
+            {
+                ev = buffer[start++];
+                switch (ev.type)
+                {
+                    case EV_KEY:
+                        tracked.SetButton(ev.code, !!ev.value);
+                        break;
+                    case EV_ABS:
+                        tracked.SetAxis(ev.code, ev.value);
+                        break;
+                    case EV_SYN:
+                        if (ev.code == SYN_DROPPED)
+                        {
+                            this->resync();
+                            return ReadStatus::SYNC;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                return ReadStatus::SUCCESS;
+            }
+            return ReadStatus::AGAIN;
+        }
+
+        ReadStatus next_delta(struct input_event& ev)
+        {
+            if (deltaNext >= delta.size())
+            {
+                delta.clear();
+                deltaNext = 0;
+                return ReadStatus::AGAIN;
+            }
+            ev = delta[deltaNext++];
+            return ReadStatus::SYNC;
+        }
+
+        // what libevdev does on SYN_DROPPED: throw away everything still
+        // queued, which is older than the state, then ask the kernel for the
+        // current state and turn whatever differs from the last known one
+        // into events
+        void resync()
+        {
+            this->drain();
+
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            struct input_event ev;
+            memset(&ev, 0, sizeof(struct input_event));
+            ev.time.tv_sec = now.tv_sec;
+            ev.time.tv_usec = now.tv_nsec / 1000;
+
+            delta.clear();
+            deltaNext = 0;
+
+            unsigned long keys[(KEY_CNT + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))];
+            memset(keys, 0, sizeof(keys));
+            if (ioctl(fd, EVIOCGKEY(sizeof(keys)), keys) >= 0)
+            {
+                const size_t bits = 8 * sizeof(unsigned long);
+                for (int code = BTN_MISC; code < KEY_CNT; code++)
+                {
+                    bool pressed = (keys[code / bits] >> (code % bits)) & 1;
+                    if (tracked.HasButton(code) && tracked.GetButton(code) != pressed)
+                    {
+                        ev.type = EV_KEY;
+                        ev.code = code;
+                        ev.value = pressed;
+                        delta.push_back(ev);
+                        tracked.SetButton(code, pressed);
+                    }
+                }
+            }
+
+            for (int code = 0; code < ABS_CNT; code++)
+            {
+                struct input_absinfo info;
+                if (!tracked.HasAxis(code) || ioctl(fd, EVIOCGABS(code), &info) < 0)
+                    continue;
+                if (tracked.GetAxis(code) != info.value)
+                {
+                    ev.type = EV_ABS;
+                    ev.code = code;
+                    ev.value = info.value;
+                    delta.push_back(ev);
+                    tracked.SetAxis(code, info.value);
+                }
+            }
+
+            ev.type = EV_SYN;
+            ev.code = SYN_REPORT;
+            ev.value = 0;
+            delta.push_back(ev);
+        }
+
+        // empties the buffer and the kernel's queue for this client; no ring read
+        // is in flight while a delivery is decoded, so this may read even when taken
+        void drain()
+        {
+            start = end = 0;
+            for (int reads = 0; reads < MAX_DRAIN_READS; reads++)
+            {
+                ssize_t rc = read(fd, buffer, sizeof(buffer));
+                if (rc < 0 && errno == EINTR)
+                    continue;
+                if (rc <= 0)
+                    break;
+            }
+        }
+
+        // 4096 events, more than evdev queues for one client
+        static const int MAX_DRAIN_READS = 64;
+
+        int fd;
+        struct libevdev *dev;
+        // udev's ID_PATH: the bus topology the device is plugged into
+        std::string portPath;
+
+        // set once reads were handed over; Next then only decodes what is delivered
+        bool taken;
+        struct input_event buffer[MAX_DELIVERY / sizeof(struct input_event)];
+        int start;
+        int end;
+        // the device's state as of the last event handed out
+        JoystickState tracked;
+        std::vector<struct input_event> delta;
+        size_t deltaNext;
+    };
+}
+
+
+UdevBackend::UdevBackend()
+{
+    udev = nullptr;
+    udev_monitor = nullptr;
+    udev_mon_fd = -1;
+}
+
+UdevBackend::~UdevBackend()
+{
+    if (udev_monitor)
+        udev_monitor_unref(udev_monitor);
+    if (udev)
+        udev_unref(udev);
+}
+
+bool UdevBackend::Start()
+{
+    // init udev
+    this->udev = udev_new();
+    if (!this->udev)
+        return false;
+
+    this->udev_monitor = udev_monitor_new_from_netlink(this->udev, "udev");
+    if (!this->udev_monitor)
+        return false;
+
+    // set monitors
+    udev_monitor_filter_add_match_subsystem_devtype(this->udev_monitor, "hid", NULL);
+    udev_monitor_filter_add_match_subsystem_devtype(this->udev_monitor, "input", NULL);
+    udev_monitor_enable_receiving(this->udev_monitor);
+    this->udev_mon_fd = udev_monitor_get_fd(this->udev_monitor);
+    return true;
+}
+
+int UdevBackend::GetFd() const
+{
+    return this->udev_mon_fd;
+}
+
+void UdevBackend::SetFilter(const DeviceFilter& filter)
+{
+    this->filter = filter;
+}
+
+void UdevBackend::Scan(std::vector<std::string>& paths)
+{
+    udev_enumerate *enumerate;
+    udev_list_entry *devices, *dev_list_entry;
+
+    enumerate = udev_enumerate_new(this->udev);
+    udev_enumerate_add_match_sysname(enumerate, "event[0-9]*");
+    udev_enumerate_add_match_subsystem(enumerate, "input");
+    if (this->filter.joysticksOnly)
+        udev_enumerate_add_match_property(enumerate, "ID_INPUT_JOYSTICK", "1");
+    udev_enumerate_scan_devices(enumerate);
+    devices = udev_enumerate_get_list_entry(enumerate);
+
+    udev_list_entry_foreach(dev_list_entry, devices)
+    {
+        const char *path;
+        const char *devnode;
+        udev_device *dev;
+
+        path = udev_list_entry_get_name(dev_list_entry);
+        dev = udev_device_new_from_syspath(this->udev, path);
+        if (!dev)
+            continue;
+
+        devnode = udev_device_get_devnode(dev);
+        if (devnode && this->accepts(dev))
+            paths.push_back(devnode);
+        udev_device_unref(dev);
+    }
+    udev_enumerate_unref(enumerate);
+}
+
+void UdevBackend::Receive(std::vector<HotplugEvent>& events)
+{
+    const char *devnode;
+    const char *action;
+    udev_device *dev;
+
+    dev = udev_monitor_receive_device(this->udev_monitor);
+    if (!dev)
+        return;
+
+    devnode = udev_device_get_devnode(dev);
+    action = udev_device_get_action(dev);
+    if (devnode && action && strstr(devnode, "event") != NULL)
+    {
+        if (strcmp(action, DEVICE_ADDED) == 0 && this->accepts(dev))
+            events.push_back({ HotplugEvent::Action::ADDED, devnode });
+        else if (strcmp(action, DEVICE_REMOVED) == 0)
+            events.push_back({ HotplugEvent::Action::REMOVED, devnode });
+    }
+
+    udev_device_unref(dev);
+}
+
+std::unique_ptr<InputDevice> UdevBackend::Open(const char *path)
+{
+    int fd;
+    struct libevdev *dev;
+
+    if ((fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC)) < 0)
+        return nullptr;
+
+    if (libevdev_new_from_fd(fd, &dev) < 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // stamp events on the same clock the latency histograms measure against
+    libevdev_set_clock_id(dev, CLOCK_MONOTONIC);
+
+    std::string portPath;
+    struct stat st;
+    if (this->udev && fstat(fd, &st) == 0)
+    {
+        udev_device *udevDevice = udev_device_new_from_devnum(this->udev, 'c', st.st_rdev);
+        if (udevDevice)
+        {
+            const char *idPath = udev_device_get_property_value(udevDevice, "ID_PATH");
+            if (idPath)
+                portPath = idPath;
+            udev_device_unref(udevDevice);
+        }
+    }
+
+    return std::unique_ptr<InputDevice>(new EvdevDevice(fd, dev, portPath));
+}
+
+bool UdevBackend::accepts(udev_device *dev) const
+{
+    if (this->filter.joysticksOnly)
+    {
+        const char *joystick = udev_device_get_property_value(dev, "ID_INPUT_JOYSTICK");
+        if (!joystick || strcmp(joystick, "1") != 0)
+            return false;
+    }
+
+    if (this->filter.everyDescriptor)
+        return true;
+
+    // udev only knows the IDs of some buses; otherwise the device has to be opened to tell
+    const char *vendor = udev_device_get_property_value(dev, "ID_VENDOR_ID");
+    const char *model = udev_device_get_property_value(dev, "ID_MODEL_ID");
+    if (!vendor || !model)
+        return true;
+
+    JoystickDescriptor descriptor;
+    descriptor.vendor_id = static_cast<int>(strtol(vendor, nullptr, 16));
+    descriptor.product_id = static_cast<int>(strtol(model, nullptr, 16));
+    return this->filter.Matches(descriptor);
+}
@@ -0,0 +1,316 @@
+#include "UringReader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+using namespace JoystickLibrary;
+
+constexpr unsigned SUBMISSION_ENTRIES = 256;
+// completions per watched device: its poll (unless skipped), its read and a cancel
+constexpr unsigned COMPLETIONS_PER_DEVICE = 4;
+// how long the destructor waits for cancelled reads to come back
+constexpr int DRAIN_ATTEMPTS = 1000;
+
+// user_data of a request: slot generation, request kind, device ID
+enum RequestKind : uint64_t
+{
+    POLL_REQUEST = 1,
+    READ_REQUEST = 2,
+    CANCEL_REQUEST = 3
+};
+
+static uint64_t UserData(uint32_t generation, RequestKind kind, int id)
+{
+    return (uint64_t(generation) << 32) | (uint64_t(kind) << 24) | uint64_t(id & 0xFFFFFF);
+}
+
+static int SetupRing(unsigned entries, struct io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int EnterRing(int ring_fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+
+UringReader::UringReader()
+{
+    ring_fd = -1;
+    skipPollSuccess = false;
+    sqRing = MAP_FAILED;
+    sqRingSize = 0;
+    cqRing = MAP_FAILED;
+    cqRingSize = 0;
+    sqes = static_cast<struct io_uring_sqe *>(MAP_FAILED);
+    sqesSize = 0;
+    sqHead = sqTail = sqArray = sqFlags = nullptr;
+    cqHead = cqTail = nullptr;
+    sqMask = cqMask = 0;
+    cqes = nullptr;
+    queued = 0;
+    enters.store(0);
+}
+
+UringReader::~UringReader()
+{
+    if (ring_fd >= 0)
+    {
+        // the kernel may still be filling buffers we are about to free
+        for (size_t id = 0; id < slots.size(); id++)
+        {
+            if (slots[id] && slots[id]->watched)
+                this->Unwatch(static_cast<int>(id));
+        }
+
+        for (int attempt = 0; attempt < DRAIN_ATTEMPTS; attempt++)
+        {
+            this->Submit();
+            this->Reap([](int, const void *, int) { });
+
+            bool pending = false;
+            for (auto& slot : slots)
+                pending = pending || (slot && slot->pending > 0);
+            if (!pending)
+                break;
+            usleep(1000);
+        }
+    }
+
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        munmap(sqRing, sqRingSize);
+    if (ring_fd >= 0)
+        close(ring_fd);
+}
+
+bool UringReader::Start(int capacity)
+{
+    if (ring_fd >= 0 || capacity <= 0)
+        return false;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(struct io_uring_params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = static_cast<unsigned>(capacity) * COMPLETIONS_PER_DEVICE;
+
+    ring_fd = SetupRing(SUBMISSION_ENTRIES, &params);
+    if (ring_fd < 0)
+        return false;
+
+#ifdef IORING_FEAT_CQE_SKIP
+    skipPollSuccess = (params.features & IORING_FEAT_CQE_SKIP) != 0;
+#endif
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+        return false;
+    cqRing = singleMap ? sqRing
+        : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED)
+        return false;
+
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = static_cast<struct io_uring_sqe *>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED)
+        return false;
+
+    char *sq = static_cast<char *>(sqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sqFlags = reinterpret_cast<unsigned *>(sq + params.sq_off.flags);
+
+    char *cq = static_cast<char *>(cqRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    slots.resize(capacity);
+    return true;
+}
+
+bool UringReader::Watch(int id, int fd)
+{
+    if (id < 0 || id >= static_cast<int>(slots.size()))
+        return false;
+
+    if (!slots[id])
+    {
+        slots[id].reset(new Slot());
+        slots[id]->generation = 0;
+        slots[id]->pending = 0;
+    }
+
+    Slot& slot = *slots[id];
+    slot.fd = fd;
+    slot.watched = true;
+    slot.armWhenIdle = false;
+
+    // one buffer per slot, so the new fd waits for the old read to come back
+    if (slot.pending > 0)
+        slot.armWhenIdle = true;
+    else
+        this->arm(id, slot);
+    return true;
+}
+
+void UringReader::Unwatch(int id)
+{
+    if (id < 0 || id >= static_cast<int>(slots.size()) || !slots[id])
+        return;
+
+    Slot& slot = *slots[id];
+    if (!slot.watched)
+        return;
+
+    slot.watched = false;
+    slot.armWhenIdle = false;
+    if (slot.pending > 0)
+    {
+        // cancelling the poll cancels the read linked to it; the read itself only if it already started
+        for (RequestKind kind : { POLL_REQUEST, READ_REQUEST })
+        {
+            struct io_uring_sqe *sqe = this->next_sqe();
+            if (!sqe)
+                break;
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = UserData(slot.generation, kind, id);
+            sqe->user_data = UserData(slot.generation, CANCEL_REQUEST, id);
+        }
+    }
+    slot.generation++;
+}
+
+void UringReader::Arm(int id)
+{
+    if (id < 0 || id >= static_cast<int>(slots.size()) || !slots[id])
+        return;
+
+    Slot& slot = *slots[id];
+    if (slot.watched && slot.pending == 0)
+        this->arm(id, slot);
+}
+
+void UringReader::Submit()
+{
+    if (ring_fd < 0)
+        return;
+
+    // completions the CQ ring had no room for are only flushed by an enter
+    unsigned flags = (__atomic_load_n(sqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) ? IORING_ENTER_GETEVENTS : 0;
+    if (!queued && !flags)
+        return;
+
+    int rc = EnterRing(ring_fd, queued, 0, flags);
+    enters.fetch_add(1, std::memory_order_relaxed);
+    if (rc > 0)
+        queued -= std::min(queued, static_cast<unsigned>(rc));
+}
+
+struct io_uring_sqe *UringReader::next_sqe()
+{
+    unsigned tail = *sqTail;
+    if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) > sqMask)
+    {
+        this->Submit();
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) > sqMask)
+            return nullptr;
+    }
+
+    unsigned index = tail & sqMask;
+    struct io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    queued++;
+    return sqe;
+}
+
+bool UringReader::next_cqe(struct io_uring_cqe& cqe)
+{
+    unsigned head = *cqHead;
+    if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+        return false;
+
+    cqe = cqes[head & cqMask];
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool UringReader::complete(const struct io_uring_cqe& cqe, int& id)
+{
+    id = static_cast<int>(cqe.user_data & 0xFFFFFF);
+    uint64_t kind = (cqe.user_data >> 24) & 0xFF;
+    uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32);
+
+    // polls only matter through the read linked to them, except that a
+    // failed poll with CQE_SKIP_SUCCESS also suppresses the read's CQE
+    bool linkDone = kind == READ_REQUEST || (kind == POLL_REQUEST && skipPollSuccess);
+    if (!linkDone || id >= static_cast<int>(slots.size()) || !slots[id])
+        return false;
+
+    Slot& slot = *slots[id];
+    slot.pending--;
+    if (slot.watched && slot.generation == generation)
+        return true;
+
+    // a read for a device that is gone; its fd may be back and waiting for the buffer
+    if (slot.pending == 0 && slot.armWhenIdle)
+    {
+        slot.armWhenIdle = false;
+        this->arm(id, slot);
+    }
+    return false;
+}
+
+void UringReader::arm(int id, Slot& slot)
+{
+    // both halves of the link have to go into the same submission
+    if (sqMask + 1 - (*sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE)) < 2)
+        this->Submit();
+
+    struct io_uring_sqe *poll = this->next_sqe();
+    if (!poll)
+        return;
+    poll->opcode = IORING_OP_POLL_ADD;
+    poll->fd = slot.fd;
+    poll->poll32_events = POLLIN;
+    poll->flags = IOSQE_IO_LINK;
+#ifdef IOSQE_CQE_SKIP_SUCCESS
+    if (skipPollSuccess)
+        poll->flags |= IOSQE_CQE_SKIP_SUCCESS;
+#endif
+    poll->user_data = UserData(slot.generation, POLL_REQUEST, id);
+
+    struct io_uring_sqe *read = this->next_sqe();
+    if (!read)
+    {
+        // keep the ring consistent; the poll completes on its own
+        poll->flags &= ~IOSQE_IO_LINK;
+        return;
+    }
+    read->opcode = IORING_OP_READ;
+    read->fd = slot.fd;
+    read->addr = reinterpret_cast<uint64_t>(slot.buffer);
+    read->len = READ_BYTES;
+    read->off = static_cast<uint64_t>(-1);
+    read->user_data = UserData(slot.generation, READ_REQUEST, id);
+    slot.pending++;
+}
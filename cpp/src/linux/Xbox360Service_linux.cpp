@@ -2,14 +2,20 @@
 
 using namespace JoystickLibrary;
 
-constexpr int X_MIN = -32768;
-constexpr int X_MAX = 32767;
-constexpr int Y_MIN = -32768;
-constexpr int Y_MAX = 32767;
-constexpr int TRIGGER_MIN = -255;
-constexpr int TRIGGER_MAX = 255;
-
-Xbox360Service::Xbox360Service() : JoystickService()
+typedef Xbox360Profile Profile;
+
+static_assert(Profile::Descriptors::COUNT == 4, "Xbox 360 profile must list every supported controller");
+
+// normalization must agree with exact division; sticks are sampled, 65536 values is too many to unroll
+static_assert(Profile::LeftX::IsExact(61) && Profile::LeftY::IsExact(67), "stick normalization is not exact");
+static_assert(Profile::RightX::IsExact(71) && Profile::RightY::IsExact(73), "stick normalization is not exact");
+static_assert(Profile::LeftTrigger::IsExact(1) && Profile::RightTrigger::IsExact(1), "trigger normalization is not exact");
+static_assert(Profile::LeftX::Normalize(-32768) == -100 && Profile::LeftX::Normalize(32767) == 100
+    && Profile::LeftX::Normalize(0) == 0 && Profile::LeftX::Normalize(-1) == 0, "sticks must span -100..100");
+static_assert(Profile::LeftTrigger::Normalize(0) == 0 && Profile::LeftTrigger::Normalize(255) == 100,
+    "triggers must read 0..100 over their reported 0..255");
+
+Xbox360Service::Xbox360Service() : Xbox360ServiceBase()
 { 
 }
 
@@ -17,117 +23,100 @@ Xbox360Service::~Xbox360Service()
 {
 }
 
-void Xbox360Service::OnDeviceChanged(DeviceStateChange ds)
-{
-    this->ProcessDeviceChange(XBOX_IDS, ds);
-}
-
 bool Xbox360Service::GetLeftX(int joystickID, int& leftX)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    leftX = NormalizeAxisValue(this->GetAxis(joystickID, ABS_X), X_MIN, X_MAX);
-    return true;
+    return this->ReadAxis<Profile::LeftX>(joystickID, leftX);
 }
 
 bool Xbox360Service::GetLeftY(int joystickID, int& leftY)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    leftY = -NormalizeAxisValue(this->GetAxis(joystickID, ABS_Y), Y_MIN, Y_MAX);
-    return true;
+    return this->ReadAxis<Profile::LeftY>(joystickID, leftY);
 }
 
 bool Xbox360Service::GetRightX(int joystickID, int& rightX)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    rightX = NormalizeAxisValue(this->GetAxis(joystickID, ABS_RX), X_MIN, X_MAX);
-    return true;
+    return this->ReadAxis<Profile::RightX>(joystickID, rightX);
 }
 
 bool Xbox360Service::GetRightY(int joystickID, int& rightY)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    rightY = -NormalizeAxisValue(this->GetAxis(joystickID, ABS_RY), Y_MIN, Y_MAX);
-    return true;
+    return this->ReadAxis<Profile::RightY>(joystickID, rightY);
 }
 
 bool Xbox360Service::GetLeftTrigger(int joystickID, int& leftTrigger)
 {
-    if (!IsValidJoystickID(joystickID))
-        return false;
-
-    leftTrigger = NormalizeAxisValue(this->GetAxis(joystickID, ABS_Z), TRIGGER_MIN, TRIGGER_MAX);
-    return true;
+    return this->ReadAxis<Profile::LeftTrigger>(joystickID, leftTrigger);
 }
 
 bool Xbox360Service::GetRightTrigger(int joystickID, int& rightTrigger)
+{
+    return this->ReadAxis<Profile::RightTrigger>(joystickID, rightTrigger);
+}
+
+bool Xbox360Service::GetDpad(int joystickID, POV& dpad)
+{
+    return this->ReadHat<Profile::Dpad>(joystickID, dpad);
+}
+
+bool Xbox360Service::GetButton(int joystickID, Xbox360Button button, bool& buttonVal)
 {
     if (!IsValidJoystickID(joystickID))
         return false;
 
-    rightTrigger = NormalizeAxisValue(this->GetAxis(joystickID, ABS_RZ), TRIGGER_MIN, TRIGGER_MAX);
+    // Xbox360Button values are the BTN_* codes themselves
+    buttonVal = this->GetState(joystickID).GetButton(static_cast<int>(button));
     return true;
 }
 
-bool Xbox360Service::GetDpad(int joystickID, POV& dpad)
+bool Xbox360Service::GetButtons(int joystickID, std::map<Xbox360Button, bool>& buttons)
 {
     if (!IsValidJoystickID(joystickID))
         return false;
 
-    POV horizontal, vertical;
-    switch (this->GetAxis(joystickID, ABS_HAT0X))
+    JoystickState state = this->GetState(joystickID);
+    for (int i = 0; i < Profile::Buttons::COUNT; i++)
     {
-        case -1:
-            horizontal = POV::POV_WEST;
-            break;
-        case 1:
-            horizontal = POV::POV_EAST;
-            break;
-        default:
-            horizontal = POV::POV_NONE;
-            break;
+        int code = Profile::Buttons::Code(i);
+        if (state.HasButton(code))
+            buttons[static_cast<Xbox360Button>(code)] = state.GetButton(code);
     }
 
-    switch (this->GetAxis(joystickID, ABS_HAT0Y))
+    return true;
+}
+
+void Xbox360Service::FillSnapshot(const JoystickState& state, Xbox360Snapshot& snapshot) const
+{
+    snapshot.leftX = Profile::LeftX::Read(state);
+    snapshot.leftY = Profile::LeftY::Read(state);
+    snapshot.rightX = Profile::RightX::Read(state);
+    snapshot.rightY = Profile::RightY::Read(state);
+    snapshot.leftTrigger = Profile::LeftTrigger::Read(state);
+    snapshot.rightTrigger = Profile::RightTrigger::Read(state);
+    snapshot.dpad = Profile::Dpad::Read(state);
+
+    snapshot.buttons = 0;
+    for (int i = 0; i < Profile::Buttons::COUNT; i++)
     {
-        case -1:
-            vertical = POV::POV_NORTH;
-            break;
-        case 1:
-            vertical = POV::POV_SOUTH;
-            break;
-        default:
-            vertical = POV::POV_NONE;
-            break;
+        int code = Profile::Buttons::Code(i);
+        if (state.GetButton(code))
+            snapshot.buttons |= 1u << (code - XBOX360_BUTTON_BASE);
     }
-
-    dpad = static_cast<POV>(static_cast<int>(vertical) | static_cast<int>(horizontal));
-    return true;
 }
 
-bool Xbox360Service::GetButton(int joystickID, Xbox360Button button, bool& buttonVal)
+bool Xbox360Service::GetSnapshot(int joystickID, Xbox360Snapshot& snapshot)
 {
     if (!IsValidJoystickID(joystickID))
         return false;
 
-    buttonVal = this->GetState(joystickID).buttons[static_cast<int>(button)];
+    FillSnapshot(this->GetState(joystickID), snapshot);
     return true;
 }
 
-bool Xbox360Service::GetButtons(int joystickID, std::map<Xbox360Button, bool>& buttons)
+bool Xbox360Service::GetSnapshot(const DeviceSnapshot& device, Xbox360Snapshot& snapshot)
 {
-    if (!IsValidJoystickID(joystickID))
+    if (!Matches(device.descriptor))
         return false;
 
-    for (auto& pair : this->GetState(joystickID).buttons)
-        buttons[static_cast<Xbox360Button>(pair.first)] = !!pair.second;
-        
+    FillSnapshot(device.state, snapshot);
     return true;
-}
\ No newline at end of file
+}
@@ -80,6 +80,29 @@ bool Extreme3DProService::GetPOV(int joystickID, POV& pov)
     return true;
 }
 
+bool Extreme3DProService::GetSnapshot(int joystickID, Extreme3DProSnapshot& snapshot)
+{
+    if (!IsValidJoystickID(joystickID))
+        return false;
+
+    JoystickState state = this->GetState(joystickID);
+    snapshot.x = state.lX;
+    snapshot.y = -state.lY;
+    snapshot.zRot = state.lRz;
+    snapshot.slider = (100 - state.rglSlider[0]) / 2;
+
+    unsigned int povListIndex = state.rgdwPOV[0] / 4500;
+    snapshot.pov = (povListIndex < povList.size()) ? povList[povListIndex] : POV::POV_NONE;
+
+    snapshot.buttons = 0;
+    for (int i = 0; i < NUMBER_BUTTONS; i++)
+    {
+        if (state.rgbButtons[i])
+            snapshot.buttons |= 1u << i;
+    }
+    return true;
+}
+
 void Extreme3DProService::OnDeviceChanged(DeviceStateChange ds)
 {
     this->ProcessDeviceChange(EXTREME_3D_PRO_IDS, ds);
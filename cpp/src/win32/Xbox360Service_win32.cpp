@@ -107,3 +107,30 @@ bool Xbox360Service::GetButtons(int joystickID, std::map<Xbox360Button, bool>& b
 
     return true;
 }
+
+bool Xbox360Service::GetSnapshot(int joystickID, Xbox360Snapshot& snapshot)
+{
+    if (!IsValidJoystickID(joystickID))
+        return false;
+
+    JoystickState state = this->GetState(joystickID);
+    snapshot.leftX = state.lX;
+    snapshot.leftY = -state.lY;
+    snapshot.rightX = state.lRx;
+    snapshot.rightY = -state.lRy;
+
+    // triggers share the lZ field. left: [0, 100], right: [0, -100]
+    snapshot.leftTrigger = (state.lZ > 0) ? state.lZ : 0;
+    snapshot.rightTrigger = (state.lZ < 0) ? -state.lZ : 0;
+
+    unsigned int povListIndex = state.rgdwPOV[0] / 4500;
+    snapshot.dpad = (povListIndex < povList.size()) ? povList[povListIndex] : POV::POV_NONE;
+
+    snapshot.buttons = 0;
+    for (int i = 0; i < NUMBER_BUTTONS; i++)
+    {
+        if (state.rgbButtons[i])
+            snapshot.buttons |= 1u << i;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+// Shared pieces of the backend tests: a service that records every device
+// change and exposes the published state, a CHECK that reports the
+// failing line and fails the test, and simulated device fixtures.
+
+#include "Extreme3DProService.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__,    \
+                #condition);                                                    \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+namespace JoystickLibrary
+{
+    class TestService : public JoystickService
+    {
+    public:
+        using JoystickService::GetState;
+
+        /**
+        * Gets the device changes seen so far, in callback order.
+        */
+        std::vector<DeviceStateChange> GetChanges()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            return changes;
+        }
+
+        /**
+        * Waits for the change after the first count ones.
+        * @return false if it did not come within two seconds, true otherwise.
+        */
+        bool WaitForChanges(size_t count, DeviceStateChange& change)
+        {
+            bool arrived = Eventually([&]() { return GetChanges().size() > count; });
+            if (arrived)
+                change = GetChanges()[count];
+            return arrived;
+        }
+
+        /**
+        * Polls a condition on published state, which the reader thread
+        * updates asynchronously.
+        * @return false if it did not hold within two seconds, true otherwise.
+        */
+        template <typename Condition>
+        static bool Eventually(Condition condition)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while (!condition())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                    return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return true;
+        }
+
+    protected:
+        void OnDeviceChanged(DeviceStateChange dsc) override
+        {
+            this->TrackDevice(dsc);
+            std::lock_guard<std::mutex> guard(lock);
+            changes.push_back(dsc);
+        }
+
+    private:
+        std::mutex lock;
+        std::vector<DeviceStateChange> changes;
+    };
+
+    /**
+    * Gets the axes and buttons of an Extreme 3D Pro at rest, to plug in
+    * simulated ones.
+    */
+    inline JoystickState Extreme3DProCaps(const Extreme3DProService& service)
+    {
+        JoystickState state = JoystickState();
+        for (int code : { ABS_X, ABS_Y, ABS_RZ, ABS_THROTTLE, ABS_HAT0X, ABS_HAT0Y })
+            state.SetAxis(code, 0);
+        for (int i = 0; i < service.NUMBER_BUTTONS; i++)
+            state.SetButton(BTN_TRIGGER + i, false);
+        return state;
+    }
+}
@@ -0,0 +1,128 @@
+// Drives one coroutine through the awaitables of JoystickCoroutines.hpp
+// against a SyntheticBackend: it awaits a device connecting, a change to
+// its axes, its trigger being pressed and finally the device going away.
+// A second coroutine is destroyed while it waits, which must cancel its
+// wait. Built only where the compiler has C++20 coroutines.
+
+#include "JoystickCoroutines.hpp"
+#include "SyntheticBackend.hpp"
+#include "TestService.hpp"
+#include <atomic>
+#include <exception>
+
+using namespace JoystickLibrary;
+
+static Extreme3DProService& service = Extreme3DProService::GetInstance();
+
+// fire-and-forget coroutine: runs until its first co_await, frees itself at the end
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() { return Task(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() { }
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// a coroutine its caller destroys, suspended or done
+struct OwnedTask
+{
+    struct promise_type
+    {
+        OwnedTask get_return_object()
+        {
+            return OwnedTask { std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_always final_suspend() noexcept { return std::suspend_always(); }
+        void return_void() { }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// how far Script got, and what each await resumed with
+static std::atomic<int> step(0);
+static std::atomic<int> addedID(-1);
+static std::atomic<bool> moved(false);
+static std::atomic<bool> pressed(false);
+static std::atomic<bool> movedAfterUnplug(true);
+
+static Task Script()
+{
+    DeviceStateChange added = co_await Enumerator::GetInstance().DeviceAdded();
+    addedID = added.id;
+    step = 1;
+
+    moved = co_await service.NextChange(added.id);
+    step = 2;
+
+    pressed = co_await service.ButtonPressed(added.id, Extreme3DProButton::Trigger);
+    step = 3;
+
+    movedAfterUnplug = co_await service.NextChange(added.id);
+    step = 4;
+}
+
+static std::atomic<bool> abandonedResumed(false);
+
+static OwnedTask Abandoned(int id)
+{
+    co_await service.NextChange(id);
+    abandonedResumed = true;
+}
+
+int main()
+{
+    SyntheticBackend *backend = new SyntheticBackend();
+    Enumerator::GetInstance().SetBackend(std::unique_ptr<InputBackend>(backend));
+    CHECK(service.Initialize());
+    CHECK(Enumerator::GetInstance().WaitUntilReady(2000));
+
+    // suspends right away; the reader thread resumes it from here on
+    Script();
+    CHECK(step == 0);
+
+    std::shared_ptr<SyntheticDevice> device = backend->Plug("/dev/input/event0", service.EXTREME_3D_PRO_IDS[0],
+        Extreme3DProCaps(service));
+    CHECK(device);
+    CHECK(TestService::Eventually([]() { return step == 1; }));
+    CHECK(addedID >= 0);
+    CHECK(service.GetNumberConnected() == 1);
+
+    device->Emit(EV_ABS, ABS_X, 512);
+    device->Report();
+    CHECK(TestService::Eventually([]() { return step == 2; }));
+    CHECK(moved);
+
+    // destroying a waiting coroutine takes its awaiter off the reader thread
+    OwnedTask abandoned = Abandoned(addedID);
+    CHECK(!abandoned.handle.done());
+    abandoned.handle.destroy();
+    int before;
+    CHECK(service.GetY(addedID, before));
+    device->Emit(EV_ABS, ABS_Y, 512);
+    device->Report();
+    CHECK(TestService::Eventually([&]() {
+        int y;
+        return service.GetY(addedID, y) && y != before;
+    }));
+    CHECK(!abandonedResumed);
+
+    device->Emit(EV_KEY, BTN_TRIGGER, 1);
+    device->Report();
+    CHECK(TestService::Eventually([]() { return step == 3; }));
+    CHECK(pressed);
+
+    // a device that goes away resumes its waiters with false
+    CHECK(backend->Unplug("/dev/input/event0"));
+    CHECK(TestService::Eventually([]() { return step == 4; }));
+    CHECK(!movedAfterUnplug);
+
+    printf("coroutine_test passed\n");
+    return 0;
+}
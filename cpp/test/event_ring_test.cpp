@@ -0,0 +1,94 @@
+// Races a consumer against the producer of an EventRing: every event it
+// copies out must be whole and in order, and every event it misses must
+// be counted as lost. Then checks that a new epoch leaves cursors stale.
+
+#include "EventRing.hpp"
+#include "TestService.hpp"
+#include <atomic>
+
+using namespace JoystickLibrary;
+
+static const uint64_t EVENTS = 2000000;
+
+// every field carries the sequence number, so a torn copy shows
+static struct input_event Event(uint64_t sequence)
+{
+    struct input_event ev;
+    memset(&ev, 0, sizeof(struct input_event));
+    ev.time.tv_sec = static_cast<time_t>(sequence);
+    ev.time.tv_usec = static_cast<suseconds_t>(sequence % 1000000);
+    ev.type = EV_ABS;
+    ev.code = static_cast<uint16_t>(sequence & 0x3F);
+    ev.value = static_cast<int32_t>(sequence);
+    return ev;
+}
+
+int main()
+{
+    EventRing *ring = new EventRing();
+
+    // caught up on an empty ring
+    struct input_event events[256];
+    EventCursor cursor = ring->NewCursor();
+    CHECK(ring->Read(cursor, events, 256) == 0);
+
+    std::atomic<bool> done(false);
+    std::thread producer([&]() {
+        for (uint64_t sequence = 0; sequence < EVENTS; sequence++)
+            ring->Push(Event(sequence));
+        done = true;
+    });
+
+    uint64_t read = 0;
+    uint64_t expected = 0;
+    while (true)
+    {
+        bool finished = done.load();
+        size_t count = ring->Read(cursor, events, 256);
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t sequence = static_cast<uint64_t>(events[i].time.tv_sec);
+            struct input_event whole = Event(sequence);
+            CHECK(memcmp(&events[i], &whole, sizeof(struct input_event)) == 0);
+            CHECK(sequence >= expected);
+            expected = sequence + 1;
+        }
+        read += count;
+        if (finished && count == 0)
+            break;
+    }
+    producer.join();
+
+    CHECK(cursor.position == EVENTS);
+    CHECK(read + cursor.lost == EVENTS);
+
+    // a new cursor from the oldest event sees the last CAPACITY - 1 events
+    EventCursor oldest = ring->OldestCursor();
+    size_t count = 0;
+    size_t got;
+    while ((got = ring->Read(oldest, events, 256)) > 0)
+    {
+        CHECK(static_cast<uint64_t>(events[0].time.tv_sec) == EVENTS - EventRing::CAPACITY + 1 + count);
+        count += got;
+    }
+    CHECK(count == EventRing::CAPACITY - 1);
+    CHECK(oldest.lost == 0);
+
+    // a new epoch leaves the old cursors stale and hides the events before it
+    ring->Reset();
+    CHECK(!ring->IsCurrent(cursor));
+    for (uint64_t sequence = EVENTS; sequence < EVENTS + 10; sequence++)
+        ring->Push(Event(sequence));
+    CHECK(ring->Read(cursor, events, 256) == 0);
+    CHECK(ring->Read(oldest, events, 256) == 0);
+
+    EventCursor fresh = ring->OldestCursor();
+    CHECK(ring->IsCurrent(fresh));
+    CHECK(ring->Read(fresh, events, 256) == 10);
+    CHECK(static_cast<uint64_t>(events[0].time.tv_sec) == EVENTS);
+
+    printf("event_ring_test passed (%llu read, %llu lost)\n", (unsigned long long) read,
+        (unsigned long long) cursor.lost);
+    delete ring;
+    return 0;
+}
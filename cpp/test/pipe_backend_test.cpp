@@ -0,0 +1,117 @@
+// Feeds a PipeBackend through pipes: whole reports, a record torn across
+// two writes, a SYN_DROPPED resync, end of stream and detaching, checking
+// the ADDED/REMOVED callbacks and the state the enumerator publishes.
+//
+// usage: pipe_backend_test [io_uring]
+
+#include "PipeBackend.hpp"
+#include "TestService.hpp"
+
+using namespace JoystickLibrary;
+
+static const JoystickDescriptor DESCRIPTOR = { 0x046d, 0xc215 };
+
+static struct input_event Event(uint16_t type, uint16_t code, int32_t value)
+{
+    struct input_event ev;
+    memset(&ev, 0, sizeof(struct input_event));
+    ev.time.tv_sec = static_cast<time_t>(MonotonicNanoseconds() / 1000000000ull);
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    return ev;
+}
+
+static void Write(int fd, const std::vector<struct input_event>& events)
+{
+    CHECK(write(fd, events.data(), events.size() * sizeof(struct input_event))
+        == static_cast<ssize_t>(events.size() * sizeof(struct input_event)));
+}
+
+static int Attach(PipeBackend& backend, const std::string& path, TestService& service, size_t changes, int& id)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    JoystickState initial = JoystickState();
+    initial.SetAxis(ABS_X, 0);
+    initial.SetButton(BTN_TRIGGER, false);
+    CHECK(backend.Attach(path, DESCRIPTOR, fds[0], initial));
+
+    DeviceStateChange change;
+    CHECK(service.WaitForChanges(changes, change));
+    CHECK(change.state == DeviceStateChange::State::ADDED);
+    id = change.id;
+    return fds[1];
+}
+
+int main(int argc, char **argv)
+{
+    PipeBackend *backend = new PipeBackend();
+    Enumerator& enumerator = Enumerator::GetInstance();
+    enumerator.SetBackend(std::unique_ptr<InputBackend>(backend));
+    if (argc > 1 && std::string(argv[1]) == "io_uring")
+        enumerator.SetReaderMode(ReaderMode::IO_URING);
+
+    TestService service;
+    CHECK(service.Initialize());
+    CHECK(enumerator.WaitUntilReady(2000));
+
+    int id;
+    int writer = Attach(*backend, "/dev/input/pipe0", service, 0, id);
+    CHECK(service.GetState(id).GetAxis(ABS_X) == 0);
+
+    // a whole report
+    Write(writer, { Event(EV_ABS, ABS_X, 10), Event(EV_KEY, BTN_TRIGGER, 1), Event(EV_SYN, SYN_REPORT, 0) });
+    CHECK(TestService::Eventually([&]() {
+        JoystickState state = service.GetState(id);
+        return state.GetAxis(ABS_X) == 10 && state.GetButton(BTN_TRIGGER);
+    }));
+
+    // a report whose first record is split across two writes
+    std::vector<struct input_event> report = { Event(EV_ABS, ABS_X, 20), Event(EV_SYN, SYN_REPORT, 0) };
+    const char *bytes = reinterpret_cast<const char *>(report.data());
+    size_t split = sizeof(struct input_event) / 2;
+    CHECK(write(writer, bytes, split) == static_cast<ssize_t>(split));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(service.GetState(id).GetAxis(ABS_X) == 10);
+    size_t rest = report.size() * sizeof(struct input_event) - split;
+    CHECK(write(writer, bytes + split, rest) == static_cast<ssize_t>(rest));
+    CHECK(TestService::Eventually([&]() { return service.GetState(id).GetAxis(ABS_X) == 20; }));
+
+    // SYN_DROPPED: the unfinished report before it is discarded, the delta after it applied
+    Write(writer, { Event(EV_ABS, ABS_X, 25), Event(EV_SYN, SYN_DROPPED, 0), Event(EV_ABS, ABS_X, 30),
+        Event(EV_KEY, BTN_TRIGGER, 0), Event(EV_SYN, SYN_REPORT, 0) });
+    CHECK(TestService::Eventually([&]() {
+        JoystickState state = service.GetState(id);
+        return state.GetAxis(ABS_X) == 30 && !state.GetButton(BTN_TRIGGER);
+    }));
+
+    // reports after the resync are read normally
+    Write(writer, { Event(EV_ABS, ABS_X, 40), Event(EV_SYN, SYN_REPORT, 0) });
+    CHECK(TestService::Eventually([&]() { return service.GetState(id).GetAxis(ABS_X) == 40; }));
+
+    // end of stream disconnects the device
+    close(writer);
+    DeviceStateChange change;
+    CHECK(service.WaitForChanges(1, change));
+    CHECK(change.state == DeviceStateChange::State::REMOVED);
+    CHECK(change.id == id);
+    CHECK(service.GetNumberConnected() == 0);
+
+    // detaching disconnects a device that is still streaming
+    int otherID;
+    int otherWriter = Attach(*backend, "/dev/input/pipe1", service, 2, otherID);
+    Write(otherWriter, { Event(EV_ABS, ABS_X, 7), Event(EV_SYN, SYN_REPORT, 0) });
+    CHECK(TestService::Eventually([&]() { return service.GetState(otherID).GetAxis(ABS_X) == 7; }));
+    CHECK(backend->Detach("/dev/input/pipe1"));
+    CHECK(service.WaitForChanges(3, change));
+    CHECK(change.state == DeviceStateChange::State::REMOVED);
+    CHECK(change.id == otherID);
+    CHECK(service.GetNumberConnected() == 0);
+    close(otherWriter);
+
+    printf("pipe_backend_test passed (%s)\n",
+        enumerator.GetReaderMode() == ReaderMode::IO_URING ? "io_uring" : "epoll");
+    return 0;
+}
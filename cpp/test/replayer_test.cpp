@@ -0,0 +1,134 @@
+// Opens hand-built recordings with InputReplayer: a well-formed one, and
+// corrupt ones whose counts would wrap the offsets or whose device paths
+// are not terminated, which Open must reject. Then checks that Play gives
+// up when no reader thread consumes what it feeds.
+
+#include "InputRecording.hpp"
+#include "TestService.hpp"
+
+using namespace JoystickLibrary;
+
+struct Recording
+{
+    RecordingHeader header;
+    RecordedEvent events[2];
+    RecordedDevice device;
+    RecordingIndex index;
+    RecordingTrailer trailer;
+};
+
+static Recording WellFormed()
+{
+    Recording recording;
+    memset(&recording, 0, sizeof(Recording));
+    memcpy(recording.header.magic, RECORDING_MAGIC, sizeof(recording.header.magic));
+    recording.header.recordSize = sizeof(RecordedEvent);
+    recording.header.deviceSize = sizeof(RecordedDevice);
+
+    recording.events[0].type = RECORD_CONNECT;
+    recording.events[1].time = 1000;
+    recording.events[1].type = RECORD_DISCONNECT;
+    strcpy(recording.device.path, "/dev/input/event0");
+    recording.index.record = 0;
+
+    recording.trailer.recordCount = 2;
+    recording.trailer.deviceOffset = offsetof(Recording, device);
+    recording.trailer.indexOffset = offsetof(Recording, index);
+    recording.trailer.deviceCount = 1;
+    recording.trailer.indexCount = 1;
+    memcpy(recording.trailer.magic, RECORDING_END_MAGIC, sizeof(recording.trailer.magic));
+    return recording;
+}
+
+static bool Open(InputReplayer& replayer, const Recording& recording)
+{
+    char path[] = "/tmp/replayer_testXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    CHECK(write(fd, &recording, sizeof(Recording)) == static_cast<ssize_t>(sizeof(Recording)));
+    close(fd);
+
+    // the mapping outlives the name
+    bool opened = replayer.Open(path);
+    unlink(path);
+    return opened;
+}
+
+static bool Open(const Recording& recording)
+{
+    InputReplayer replayer;
+    return Open(replayer, recording);
+}
+
+int main()
+{
+    static_assert(sizeof(Recording) == sizeof(RecordingHeader) + 2 * sizeof(RecordedEvent) + sizeof(RecordedDevice)
+        + sizeof(RecordingIndex) + sizeof(RecordingTrailer), "Recording must not be padded");
+
+    CHECK(Open(WellFormed()));
+
+    // counts whose offsets wrap back to the trailer
+    Recording recording = WellFormed();
+    recording.trailer.recordCount += (UINT64_MAX / sizeof(RecordedEvent)) + 1;
+    CHECK(!Open(recording));
+
+    recording = WellFormed();
+    recording.trailer.recordCount = UINT64_MAX;
+    CHECK(!Open(recording));
+
+    recording = WellFormed();
+    recording.trailer.indexCount = UINT32_MAX;
+    CHECK(!Open(recording));
+
+    recording = WellFormed();
+    recording.trailer.deviceCount = 2;
+    CHECK(!Open(recording));
+
+    // a path without its NUL
+    recording = WellFormed();
+    memset(recording.device.path, 'x', sizeof(recording.device.path));
+    CHECK(!Open(recording));
+
+    // nothing reads the device, so Play gives up instead of waiting forever
+    recording = WellFormed();
+    recording.events[1].type = EV_ABS;
+    recording.events[1].code = ABS_X;
+    recording.events[1].value = 5;
+    InputReplayer replayer;
+    CHECK(Open(replayer, recording));
+    std::unique_ptr<InputBackend> backend = replayer.CreateBackend();
+    auto started = std::chrono::steady_clock::now();
+    CHECK(!replayer.Play(ReplaySpeed::AS_FAST_AS_POSSIBLE));
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(10));
+
+    // an ID that comes back as another device is recorded as a second device
+    char path[] = "/tmp/replayer_testXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    JoystickState initial = JoystickState();
+    initial.SetAxis(ABS_X, 0);
+    struct input_event ev;
+    memset(&ev, 0, sizeof(struct input_event));
+    ev.type = EV_ABS;
+
+    InputRecorder recorder;
+    CHECK(recorder.Open(path));
+    recorder.RecordConnect(0, { 0x046d, 0xc215 }, "uniq:a", "/dev/input/event0", initial);
+    for (uint64_t i = 0; i < 3 * InputRecorder::INDEX_STRIDE; i++)
+        recorder.RecordEvent(0, ev);
+    recorder.RecordDisconnect(0);
+    recorder.RecordConnect(0, { 0x046d, 0xc215 }, "uniq:a", "/dev/input/event0", initial);
+    recorder.RecordDisconnect(0);
+    recorder.RecordConnect(0, { 0x045e, 0x028e }, "", "/dev/input/event1", initial);
+    CHECK(recorder.Close());
+
+    InputReplayer recorded;
+    CHECK(recorded.Open(path));
+    unlink(path);
+    CHECK(recorded.GetDeviceCount() == 2);
+    CHECK(recorded.GetRecordCount() == 3 * InputRecorder::INDEX_STRIDE + 3 * 3 + 2);
+
+    printf("replayer_test passed\n");
+    return 0;
+}
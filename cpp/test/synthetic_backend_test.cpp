@@ -0,0 +1,135 @@
+// Scripts a SyntheticBackend through plug, input, SYN_DROPPED resync, a
+// read failure and unplug/replug, checking the ADDED/REMOVED callbacks
+// and the state the enumerator publishes after each step. Last, callbacks
+// bring up more services from inside a callback.
+
+#include "SyntheticBackend.hpp"
+#include "TestService.hpp"
+
+using namespace JoystickLibrary;
+
+static const JoystickDescriptor DESCRIPTOR = { 0x046d, 0xc215 };
+
+static JoystickState Initial()
+{
+    JoystickState state = JoystickState();
+    state.SetAxis(ABS_X, 0);
+    state.SetAxis(ABS_Y, 0);
+    state.SetButton(BTN_TRIGGER, false);
+    return state;
+}
+
+// initializes one chained service from each of its first two callbacks
+class ChainingService : public TestService
+{
+public:
+    TestService chained[2];
+
+protected:
+    void OnDeviceChanged(DeviceStateChange dsc) override
+    {
+        size_t seen = this->GetChanges().size();
+        TestService::OnDeviceChanged(dsc);
+        if (seen < 2)
+            CHECK(chained[seen].Initialize());
+    }
+};
+
+int main()
+{
+    SyntheticBackend *backend = new SyntheticBackend();
+    Enumerator::GetInstance().SetBackend(std::unique_ptr<InputBackend>(backend));
+    TestService service;
+    CHECK(service.Initialize());
+    CHECK(Enumerator::GetInstance().WaitUntilReady(2000));
+
+    // plug
+    DeviceStateChange change;
+    std::shared_ptr<SyntheticDevice> device = backend->Plug("/dev/input/event0", DESCRIPTOR, Initial());
+    CHECK(device);
+    CHECK(service.WaitForChanges(0, change));
+    CHECK(change.state == DeviceStateChange::State::ADDED);
+    CHECK(change.descriptor == DESCRIPTOR);
+    int id = change.id;
+    CHECK(service.GetNumberConnected() == 1);
+    CHECK(service.GetState(id).GetAxis(ABS_X) == 0);
+
+    // input
+    device->Emit(EV_ABS, ABS_X, 100);
+    device->Emit(EV_KEY, BTN_TRIGGER, 1);
+    device->Report();
+    CHECK(TestService::Eventually([&]() {
+        JoystickState state = service.GetState(id);
+        return state.GetAxis(ABS_X) == 100 && state.GetButton(BTN_TRIGGER);
+    }));
+
+    // SYN_DROPPED: the queued report is lost, the sync delta catches up
+    device->Emit(EV_ABS, ABS_X, 200);
+    device->Emit(EV_ABS, ABS_Y, -50);
+    device->Emit(EV_KEY, BTN_TRIGGER, 0);
+    device->Report();
+    uint64_t dropped = MonotonicNanoseconds() / 1000 * 1000;   // events carry microseconds
+    device->DropEvents();
+    CHECK(TestService::Eventually([&]() {
+        JoystickState state = service.GetState(id);
+        return state.GetAxis(ABS_X) == 200 && state.GetAxis(ABS_Y) == -50 && !state.GetButton(BTN_TRIGGER);
+    }));
+    CHECK(device->GetQueued() == 0);
+    CHECK(service.GetState(id).eventTime >= dropped);
+
+    // reports after the resync are read normally
+    device->Emit(EV_ABS, ABS_X, 300);
+    device->Report();
+    CHECK(TestService::Eventually([&]() { return service.GetState(id).GetAxis(ABS_X) == 300; }));
+
+    // a read error disconnects the device
+    device->FailReads();
+    CHECK(service.WaitForChanges(1, change));
+    CHECK(change.state == DeviceStateChange::State::REMOVED);
+    CHECK(change.id == id);
+    CHECK(TestService::Eventually([&]() { return device->IsReleased(); }));
+    CHECK(service.GetNumberConnected() == 0);
+
+    // unplug and replug at the same path gets the same ID back
+    std::shared_ptr<SyntheticDevice> other = backend->Plug("/dev/input/event1", DESCRIPTOR, Initial());
+    CHECK(other);
+    CHECK(service.WaitForChanges(2, change));
+    CHECK(change.state == DeviceStateChange::State::ADDED);
+    int otherID = change.id;
+    CHECK(otherID != id);
+
+    CHECK(backend->Unplug("/dev/input/event1"));
+    CHECK(service.WaitForChanges(3, change));
+    CHECK(change.state == DeviceStateChange::State::REMOVED);
+    CHECK(change.id == otherID);
+    CHECK(TestService::Eventually([&]() { return other->IsReleased(); }));
+
+    JoystickState moved = Initial();
+    moved.SetAxis(ABS_X, 42);
+    other = backend->Plug("/dev/input/event1", DESCRIPTOR, moved);
+    CHECK(other);
+    CHECK(service.WaitForChanges(4, change));
+    CHECK(change.state == DeviceStateChange::State::ADDED);
+    CHECK(change.id == otherID);
+    CHECK(service.GetState(otherID).GetAxis(ABS_X) == 42);
+    CHECK(service.GetNumberConnected() == 1);
+
+    // registering from an announcement, then from a live change
+    ChainingService chaining;
+    CHECK(chaining.Initialize());
+    CHECK(chaining.GetChanges().size() == 1);
+    CHECK(chaining.chained[0].GetChanges().size() == 1);
+
+    std::shared_ptr<SyntheticDevice> third = backend->Plug("/dev/input/event2", DESCRIPTOR, Initial());
+    CHECK(third);
+    CHECK(chaining.WaitForChanges(1, change));
+    CHECK(change.state == DeviceStateChange::State::ADDED);
+    int thirdID = change.id;
+    CHECK(chaining.chained[0].WaitForChanges(1, change));
+    CHECK(change.id == thirdID);
+    CHECK(chaining.chained[1].WaitForChanges(1, change));
+    CHECK(chaining.chained[1].GetNumberConnected() == 2);
+
+    printf("synthetic_backend_test passed\n");
+    return 0;
+}